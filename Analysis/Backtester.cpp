@@ -0,0 +1,257 @@
+#include "Backtester.h"
+#include "IndicatorState.h"
+#include "PriceStore.h"
+#include "StockAnalysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+    // Bars [Begin, End) of one symbol, indexes are relative to the symbol's first bar
+    struct Segment {
+        std::size_t Symbol;
+        std::size_t Begin;
+        std::size_t End;
+    };
+
+    struct BucketSums {
+        std::size_t Bars = 0;
+        std::size_t Hits = 0;
+        double ReturnSum = 0.0;
+    };
+
+    struct SymbolResult {
+        std::vector<BacktestTrade> Trades;
+        std::array<BucketSums, 10> Buckets{};
+        std::size_t BarsScored = 0;
+    };
+
+    // Runs task(i) for every i in [0, count), threads claim one index at a time so uneven tasks still balance
+    template <typename Task>
+    unsigned forEachParallel(std::size_t count, unsigned threadLimit, Task task) {
+        unsigned workerCount = static_cast<unsigned>(std::clamp<std::size_t>(count, 1, threadLimit));
+        std::atomic<std::size_t> next{0};
+
+        auto work = [&]() {
+            for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+                task(i);
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount - 1);
+
+        for (unsigned i = 1; i < workerCount; ++i)
+            workers.emplace_back(work);
+
+        work();
+
+        for (std::thread& worker : workers)
+            worker.join();
+
+        return workerCount;
+    }
+}
+
+Backtester::Backtester(unsigned threadLimit)
+    : threads(threadLimit != 0 ? threadLimit : std::max(1u, std::thread::hardware_concurrency())) {}
+
+unsigned Backtester::threadCount() const {
+    return threads;
+}
+
+BacktestReport Backtester::run(const PriceStore& store, const BacktestOptions& options) {
+    auto startTime = std::chrono::steady_clock::now();
+    // Never shorter than the weighted indicators need, or every card would come out invalid
+    const std::size_t window = static_cast<std::size_t>(std::max(options.windowBars, options.weights.historyBars()));
+    const std::size_t maxHold = static_cast<std::size_t>(std::max(1, options.maxHoldBars));
+    const std::vector<std::size_t>& offsets = store.symbolOffsets();
+    const std::size_t symbolCount = store.symbolCount();
+    BacktestReport report;
+
+    // One total score per stored bar, NaN where the window is not valid
+    std::vector<double> scores(store.barCount(), std::numeric_limits<double>::quiet_NaN());
+    std::vector<Segment> segments;
+
+    for (std::size_t i = 0; i < symbolCount; ++i) {
+        std::size_t barCount = store.size(i);
+
+        if (barCount < window)
+            continue;
+
+        ++report.Symbols;
+
+        for (std::size_t begin = window - 1; begin < barCount; begin += segmentBars)
+            segments.push_back({ i, begin, std::min(begin + segmentBars, barCount) });
+    }
+
+    // Scoring, the bulk of the work, split into fixed slices so the result is the same on any number of threads
+    report.Threads = forEachParallel(segments.size(), threads, [&](std::size_t index) {
+        const Segment& segment = segments[index];
+        std::span<const double> closes = store.closes(segment.Symbol);
+        std::span<const qint64> timestamps = store.timestamps(segment.Symbol);
+        double* out = scores.data() + offsets[segment.Symbol];
+        // Running close sums only cover MA, RSI and BB, the other indicators have no O(1) update and take a full pass
+        if (options.weights.usesBars()) {
+            BarSeries bars = store.series(segment.Symbol);
+
+            for (std::size_t t = segment.Begin; t < segment.End; ++t) {
+                ScoreCard card = StockAnalysis::calculateTotalScores(closes[t], bars.subseries(t + 1 - window, window), options.weights);
+
+                if (card.Valid)
+                    out[t] = card.Total_Score;
+            }
+
+            return;
+        }
+
+        IndicatorState state = IndicatorState::fromSeries(closes.subspan(segment.Begin + 1 - window, window), timestamps[segment.Begin]);
+
+        for (std::size_t t = segment.Begin; t < segment.End; ++t) {
+            if (t > segment.Begin)
+                state.slide(closes[t - window], closes[t - window + 1], closes[t], timestamps[t]);
+
+            ScoreCard card = StockAnalysis::calculateTotalScores(closes[t], state.indicators(), options.weights);
+
+            if (card.Valid)
+                out[t] = card.Total_Score;
+        }
+    });
+
+    report.Segments = segments.size();
+
+    // Trading, one position per symbol at a time, signals on a close enter on the next open
+    std::vector<SymbolResult> results(symbolCount);
+
+    forEachParallel(symbolCount, threads, [&](std::size_t symbol) {
+        const std::size_t barCount = store.size(symbol);
+
+        if (barCount < window)
+            return;
+
+        std::span<const double> opens = store.opens(symbol);
+        std::span<const double> closes = store.closes(symbol);
+        std::span<const qint64> timestamps = store.timestamps(symbol);
+        const double* score = scores.data() + offsets[symbol];
+        SymbolResult& result = results[symbol];
+        BacktestTrade position;
+        std::size_t entryBar = 0;
+        bool holding = false;
+
+        for (std::size_t t = window - 1; t < barCount; ++t) {
+            const bool valid = !std::isnan(score[t]);
+            const bool inRange = timestamps[t] >= options.since && timestamps[t] <= options.until;
+
+            if (valid)
+                ++result.BarsScored;
+
+            if (valid && inRange && t + maxHold < barCount && closes[t] > 0) {
+                double forwardReturn = closes[t + maxHold] / closes[t] - 1.0;
+                BucketSums& bucket = result.Buckets[static_cast<std::size_t>(std::clamp(static_cast<int>(score[t] * 10.0), 0, 9))];
+
+                ++bucket.Bars;
+                bucket.ReturnSum += forwardReturn;
+
+                if (forwardReturn > 0)
+                    ++bucket.Hits;
+            }
+
+            if (holding) {
+                double change = closes[t] / position.EntryPrice - 1.0;
+                bool exit = t - entryBar >= maxHold || t + 1 == barCount ||
+                            (options.takeProfit > 0 && change >= options.takeProfit) ||
+                            (options.stopLoss > 0 && change <= -options.stopLoss) ||
+                            (options.exitScore > 0 && valid && score[t] < options.exitScore);
+
+                if (exit) {
+                    position.ExitTimestamp = timestamps[t];
+                    position.ExitPrice = closes[t];
+                    position.Return = change;
+                    position.Profit = static_cast<double>(position.Shares) * (position.ExitPrice - position.EntryPrice);
+                    result.Trades.push_back(position);
+                    holding = false;
+                }
+            }
+
+            if (holding || !valid || !inRange || t + 1 >= barCount)
+                continue;
+
+            if (score[t] < options.entryScore || score[t] >= options.scoreCeiling || opens[t + 1] <= 0)
+                continue;
+
+            // Whole shares within the budget, a share priced above it cannot be bought at all
+            qint64 shares = options.budget > 0 ? static_cast<qint64>(std::floor(options.budget / opens[t + 1])) : 1;
+
+            if (shares == 0)
+                continue;
+
+            position = BacktestTrade{};
+            position.SymbolIndex = symbol;
+            position.EntryTimestamp = timestamps[t + 1];
+            position.EntryPrice = opens[t + 1];
+            position.EntryScore = score[t];
+            position.Shares = shares;
+            entryBar = t + 1;
+            holding = true;
+        }
+    });
+
+    // Merged in symbol order, so sums and tie order do not depend on scheduling
+    std::array<BucketSums, 10> buckets{};
+    double returnSum = 0.0;
+
+    for (SymbolResult& result : results) {
+        report.BarsScored += result.BarsScored;
+
+        for (std::size_t b = 0; b < buckets.size(); ++b) {
+            buckets[b].Bars += result.Buckets[b].Bars;
+            buckets[b].Hits += result.Buckets[b].Hits;
+            buckets[b].ReturnSum += result.Buckets[b].ReturnSum;
+        }
+
+        report.TradeList.insert(report.TradeList.end(), result.Trades.begin(), result.Trades.end());
+    }
+
+    for (std::size_t b = 0; b < buckets.size(); ++b) {
+        ScoreBucket& bucket = report.Buckets[b];
+
+        bucket.LowerBound = static_cast<double>(b) / 10.0;
+        bucket.Bars = buckets[b].Bars;
+
+        if (bucket.Bars > 0) {
+            bucket.MeanForwardReturn = buckets[b].ReturnSum / static_cast<double>(bucket.Bars);
+            bucket.HitRate = static_cast<double>(buckets[b].Hits) / static_cast<double>(bucket.Bars);
+        }
+    }
+
+    std::stable_sort(report.TradeList.begin(), report.TradeList.end(), [](const BacktestTrade& a, const BacktestTrade& b) {
+        return a.ExitTimestamp < b.ExitTimestamp;
+    });
+
+    double cumulativeProfit = 0.0;
+    double peakProfit = 0.0;
+
+    for (const BacktestTrade& trade : report.TradeList) {
+        cumulativeProfit += trade.Profit;
+        peakProfit = std::max(peakProfit, cumulativeProfit);
+        report.MaxDrawdown = std::max(report.MaxDrawdown, peakProfit - cumulativeProfit);
+        returnSum += trade.Return;
+
+        if (trade.Return > 0)
+            ++report.Hits;
+    }
+
+    report.Trades = report.TradeList.size();
+    report.TotalProfit = cumulativeProfit;
+
+    if (report.Trades > 0) {
+        report.HitRate = static_cast<double>(report.Hits) / static_cast<double>(report.Trades);
+        report.MeanReturn = returnSum / static_cast<double>(report.Trades);
+    }
+
+    report.ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    return report;
+}
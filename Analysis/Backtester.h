@@ -0,0 +1,84 @@
+#ifndef BACKTESTER_H
+#define BACKTESTER_H
+
+#include "StockAnalysis.h"
+
+#include <QtGlobal>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+class PriceStore;
+
+struct BacktestOptions {
+    int windowBars = 28;                  // Closes per scoring window, about a scan's 40 days, at least ScoreWeights::historyBars()
+    double entryScore = 0.8;              // A close scoring at least this enters on the next bar's open
+    double exitScore = 0.0;               // Exit once the score falls below this, 0 disables
+    int maxHoldBars = 10;                 // Exit on the close this many bars after entry
+    double takeProfit = 0.10;             // Exit once a close is this far above the entry, 0 disables
+    double stopLoss = 0.05;               // Exit once a close is this far below the entry, 0 disables
+    double budget = 0.0;                  // Capital per trade in whole shares, pricier entries are skipped. 0 trades one share
+    double scoreCeiling = 1.1;            // Scores at or above this are treated as erroneous, as in a scan
+    qint64 since = 0;                     // Only enter on bars in [since, until]
+    qint64 until = std::numeric_limits<qint64>::max();
+    ScoreWeights weights;                 // Weights with bar-based indicators rerun the pipeline over every window
+};
+
+struct BacktestTrade {
+    std::size_t SymbolIndex = 0;          // Index into the PriceStore the backtest ran on
+    qint64 EntryTimestamp = 0;
+    qint64 ExitTimestamp = 0;
+    double EntryPrice = 0.0;
+    double ExitPrice = 0.0;
+    double EntryScore = 0.0;              // Score of the signal bar
+    qint64 Shares = 0;
+    double Return = 0.0;                  // Exit over entry price, minus one
+    double Profit = 0.0;                  // Shares times the price change
+};
+
+// Forward returns of every scored bar whose total score falls into [LowerBound, LowerBound + 0.1), the last bucket is open
+struct ScoreBucket {
+    double LowerBound = 0.0;
+    std::size_t Bars = 0;
+    double MeanForwardReturn = 0.0;       // Close maxHoldBars later over the scored close, minus one
+    double HitRate = 0.0;                 // Share of bars with a positive forward return
+};
+
+struct BacktestReport {
+    std::size_t Symbols = 0;              // Symbols with enough history for at least one window
+    std::size_t BarsScored = 0;
+    std::size_t Trades = 0;
+    std::size_t Hits = 0;                 // Trades with a positive return
+    double HitRate = 0.0;
+    double MeanReturn = 0.0;
+    double TotalProfit = 0.0;
+    double MaxDrawdown = 0.0;             // Largest drop of cumulative profit from its running peak, trades ordered by exit
+    std::array<ScoreBucket, 10> Buckets;
+    std::vector<BacktestTrade> TradeList; // Ordered by exit time
+
+    unsigned Threads = 0;
+    std::size_t Segments = 0;
+    double ElapsedMs = 0.0;
+};
+
+// Slides the scan's scoring window across every stored bar and trades the signals. Scoring runs in parallel over fixed
+// slices of each symbol's history, so long histories split across cores too and results do not depend on the thread
+// count. Trades are then simulated per symbol, one position at a time, with no database access.
+class Backtester {
+public:
+    // Bars scored per task, each task re-seeds its window from the closes before it
+    static constexpr std::size_t segmentBars = 4096;
+
+    // Zero threads uses every hardware thread
+    explicit Backtester(unsigned threads = 0);
+
+    BacktestReport run(const PriceStore& store, const BacktestOptions& options);
+
+    unsigned threadCount() const;
+
+private:
+    unsigned threads;
+};
+
+#endif // BACKTESTER_H
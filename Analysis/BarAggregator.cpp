@@ -0,0 +1,125 @@
+#include "BarAggregator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    constexpr qint64 secondsPerDay = 86400;
+
+    // Rounds towards negative infinity, timestamps before 1970 still land in the right bucket
+    qint64 floorDiv(qint64 value, qint64 divisor) {
+        qint64 quotient = value / divisor;
+
+        return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+    }
+
+    const char* const timeframeNames[] = { "1Min", "1Hour", "1Day", "1Week", "1Month" };
+
+    // Alpaca's short forms, the scan itself asks for 1D
+    const char* const timeframeAliases[] = { "1T", "1H", "1D", "1W", "1M" };
+
+    bool equalsIgnoringCase(const std::string& text, const char* name) {
+        return std::equal(text.begin(), text.end(), name, name + std::strlen(name), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    }
+}
+
+const char* BarAggregator::timeframeName(Timeframe timeframe) {
+    return timeframeNames[static_cast<int>(timeframe)];
+}
+
+bool BarAggregator::parseTimeframe(const std::string& name, Timeframe& timeframe) {
+    for (int i = 0; i < static_cast<int>(std::size(timeframeNames)); ++i) {
+        if (equalsIgnoringCase(name, timeframeNames[i]) || name == timeframeAliases[i]) {
+            timeframe = static_cast<Timeframe>(i);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+qint64 BarAggregator::bucketStart(Timeframe timeframe, qint64 timestamp) {
+    if (timeframe == Timeframe::Minute)
+        return floorDiv(timestamp, 60) * 60;
+
+    if (timeframe == Timeframe::Hour)
+        return floorDiv(timestamp, 3600) * 3600;
+
+    qint64 day = floorDiv(timestamp + sessionOffset, secondsPerDay);
+
+    if (timeframe == Timeframe::Week) {
+        // 1970-01-01 was a Thursday, weeks start on Monday
+        day -= ((day + 3) % 7 + 7) % 7;
+    } else if (timeframe == Timeframe::Month) {
+        using namespace std::chrono;
+
+        year_month_day date{ sys_days{ days{ day } } };
+        day = sys_days{ date.year() / date.month() / 1 }.time_since_epoch().count();
+    }
+
+    return day * secondsPerDay - sessionOffset;
+}
+
+BarAggregator::BarAggregator(Timeframe target) : timeframe(target) {}
+
+Timeframe BarAggregator::target() const {
+    return timeframe;
+}
+
+void BarAggregator::reset() {
+    open = RollupBar();
+    openTouched = false;
+    closed.clear();
+}
+
+bool BarAggregator::add(const BarData& bar) {
+    if (open.BaseBars > 0 && bar.Timestamp <= open.LastTimestamp)
+        return false;
+
+    qint64 bucket = bucketStart(timeframe, bar.Timestamp);
+
+    if (open.BaseBars > 0 && bucket == open.Timestamp) {
+        open.High = std::max(open.High, bar.High);
+        open.Low = std::min(open.Low, bar.Low);
+        open.Close = bar.Close;
+        open.Volume += bar.Volume;
+        ++open.BaseBars;
+        open.LastTimestamp = bar.Timestamp;
+        openTouched = true;
+
+        return true;
+    }
+
+    // The bar starts a new bucket, the previous one is complete
+    if (openTouched)
+        closed.push_back(open);
+
+    open = RollupBar{ bucket, bar.Open, bar.High, bar.Low, bar.Close, bar.Volume, 1, bar.Timestamp };
+    openTouched = true;
+
+    return true;
+}
+
+void BarAggregator::drain(std::vector<RollupBar>& touched) {
+    touched.insert(touched.end(), closed.begin(), closed.end());
+    closed.clear();
+
+    if (openTouched)
+        touched.push_back(open);
+
+    openTouched = false;
+}
+
+void BarAggregator::aggregate(std::span<const BarData> bars, Timeframe target, std::vector<RollupBar>& rollups) {
+    BarAggregator aggregator(target);
+
+    for (const BarData& bar : bars)
+        aggregator.add(bar);
+
+    aggregator.drain(rollups);
+}
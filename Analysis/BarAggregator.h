@@ -0,0 +1,71 @@
+#ifndef BAR_AGGREGATOR_H
+#define BAR_AGGREGATOR_H
+
+#include "Core/MarketData.h"
+
+#include <QtGlobal>
+#include <span>
+#include <string>
+#include <vector>
+
+// Ordered finest first, each one nests in the next apart from weeks, which straddle month boundaries
+enum class Timeframe {
+    Minute,
+    Hour,
+    Day,
+    Week,
+    Month
+};
+
+// One bar of a coarser timeframe built from base bars. Timestamp is the start of the bucket, the base bars it holds
+// are counted so a partial bucket can be told apart from a complete one.
+struct RollupBar {
+    qint64 Timestamp = 0;
+    double Open = 0.0;
+    double High = 0.0;
+    double Low = 0.0;
+    double Close = 0.0;
+    qint64 Volume = 0;
+    int BaseBars = 0;          // Zero for an empty bucket
+    qint64 LastTimestamp = 0;  // Newest base bar folded in, later ones continue from here
+};
+
+// Streams base bars, oldest first, into buckets of one coarser timeframe. Only the newest bucket is kept open, so a
+// series of any length is rolled up in one pass and closed buckets can be handed off as soon as they complete.
+class BarAggregator {
+public:
+    // Days, weeks and months follow the New York trading date. A fixed UTC-4 boundary keeps every US session,
+    // extended hours included, inside one date all year without a time zone database.
+    static constexpr qint64 sessionOffset = -4 * 3600;
+
+    // Alpaca's names, 1Min, 1Hour, 1Day, 1Week and 1Month. Parsing ignores case and also takes 1T, 1H, 1D, 1W and 1M.
+    static const char* timeframeName(Timeframe timeframe);
+    static bool parseTimeframe(const std::string& name, Timeframe& timeframe);
+
+    // Unix timestamp at which the bucket holding timestamp starts
+    static qint64 bucketStart(Timeframe timeframe, qint64 timestamp);
+
+    explicit BarAggregator(Timeframe target);
+
+    Timeframe target() const;
+
+    // Forgets everything, the next bar opens a new bucket
+    void reset();
+
+    // Returns false and ignores the bar if it is not newer than the last one folded in
+    bool add(const BarData& bar);
+
+    // Appends every bucket touched since the last drain, oldest first. The newest one stays open and keeps merging.
+    void drain(std::vector<RollupBar>& touched);
+
+    // Rolls a whole series up at once
+    static void aggregate(std::span<const BarData> bars, Timeframe target, std::vector<RollupBar>& rollups);
+
+private:
+    Timeframe timeframe;
+    RollupBar open;
+    bool openTouched = false;
+    std::vector<RollupBar> closed;
+};
+
+#endif // BAR_AGGREGATOR_H
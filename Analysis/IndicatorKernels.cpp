@@ -0,0 +1,242 @@
+#include "IndicatorKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define STOCKHOUND_X86_64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STOCKHOUND_TARGET_AVX2
+#else
+#define STOCKHOUND_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+    // Everything one pass over a window needs. Prices are summed relative to Shift, the window's first close, so the
+    // variance comes from small numbers and does not lose precision to cancellation.
+    struct WindowSums {
+        double Shift = 0.0;
+        double Sum = 0.0;
+        double SumSquares = 0.0;
+        double Gain = 0.0;
+        double Loss = 0.0;
+    };
+
+    using AccumulateKernel = void (*)(const double* values, std::size_t count, WindowSums& sums);
+
+    // Folds values[start, count) into the sums, changes are taken between consecutive values
+    void scalarAccumulateFrom(const double* values, std::size_t start, std::size_t count, WindowSums& sums) {
+        for (std::size_t i = start; i < count; ++i) {
+            double shifted = values[i] - sums.Shift;
+            sums.Sum += shifted;
+            sums.SumSquares += shifted * shifted;
+
+            if (i + 1 < count) {
+                double change = values[i + 1] - values[i];
+
+                if (change > 0)
+                    sums.Gain += change;
+                else
+                    sums.Loss -= change;
+            }
+        }
+    }
+
+    void scalarAccumulate(const double* values, std::size_t count, WindowSums& sums) {
+        scalarAccumulateFrom(values, 0, count, sums);
+    }
+
+#ifdef STOCKHOUND_X86_64
+    void sse2Accumulate(const double* values, std::size_t count, WindowSums& sums) {
+        __m128d shift = _mm_set1_pd(sums.Shift);
+        __m128d sum = _mm_setzero_pd();
+        __m128d sumSquares = _mm_setzero_pd();
+        __m128d gains = _mm_setzero_pd();
+        __m128d losses = _mm_setzero_pd();
+        __m128d zero = _mm_setzero_pd();
+        std::size_t i = 0;
+
+        for (; i + 3 <= count; i += 2) {
+            __m128d current = _mm_loadu_pd(values + i);
+            __m128d shifted = _mm_sub_pd(current, shift);
+            __m128d change = _mm_sub_pd(_mm_loadu_pd(values + i + 1), current);
+
+            sum = _mm_add_pd(sum, shifted);
+            sumSquares = _mm_add_pd(sumSquares, _mm_mul_pd(shifted, shifted));
+            gains = _mm_add_pd(gains, _mm_max_pd(change, zero));
+            losses = _mm_add_pd(losses, _mm_max_pd(_mm_sub_pd(zero, change), zero));
+        }
+
+        double lanes[4][2];
+        _mm_storeu_pd(lanes[0], sum);
+        _mm_storeu_pd(lanes[1], sumSquares);
+        _mm_storeu_pd(lanes[2], gains);
+        _mm_storeu_pd(lanes[3], losses);
+
+        sums.Sum = lanes[0][0] + lanes[0][1];
+        sums.SumSquares = lanes[1][0] + lanes[1][1];
+        sums.Gain = lanes[2][0] + lanes[2][1];
+        sums.Loss = lanes[3][0] + lanes[3][1];
+
+        scalarAccumulateFrom(values, i, count, sums);
+    }
+
+    STOCKHOUND_TARGET_AVX2 void avx2Accumulate(const double* values, std::size_t count, WindowSums& sums) {
+        __m256d shift = _mm256_set1_pd(sums.Shift);
+        __m256d sum = _mm256_setzero_pd();
+        __m256d sumSquares = _mm256_setzero_pd();
+        __m256d gains = _mm256_setzero_pd();
+        __m256d losses = _mm256_setzero_pd();
+        __m256d zero = _mm256_setzero_pd();
+        std::size_t i = 0;
+
+        for (; i + 5 <= count; i += 4) {
+            __m256d current = _mm256_loadu_pd(values + i);
+            __m256d shifted = _mm256_sub_pd(current, shift);
+            __m256d change = _mm256_sub_pd(_mm256_loadu_pd(values + i + 1), current);
+
+            sum = _mm256_add_pd(sum, shifted);
+            sumSquares = _mm256_add_pd(sumSquares, _mm256_mul_pd(shifted, shifted));
+            gains = _mm256_add_pd(gains, _mm256_max_pd(change, zero));
+            losses = _mm256_add_pd(losses, _mm256_max_pd(_mm256_sub_pd(zero, change), zero));
+        }
+
+        double lanes[4][4];
+        _mm256_storeu_pd(lanes[0], sum);
+        _mm256_storeu_pd(lanes[1], sumSquares);
+        _mm256_storeu_pd(lanes[2], gains);
+        _mm256_storeu_pd(lanes[3], losses);
+
+        sums.Sum = (lanes[0][0] + lanes[0][1]) + (lanes[0][2] + lanes[0][3]);
+        sums.SumSquares = (lanes[1][0] + lanes[1][1]) + (lanes[1][2] + lanes[1][3]);
+        sums.Gain = (lanes[2][0] + lanes[2][1]) + (lanes[2][2] + lanes[2][3]);
+        sums.Loss = (lanes[3][0] + lanes[3][1]) + (lanes[3][2] + lanes[3][3]);
+
+        // The tail below is legacy SSE code, with dirty upper halves every instruction of it pays a state transition
+        _mm256_zeroupper();
+
+        scalarAccumulateFrom(values, i, count, sums);
+    }
+
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 0);
+
+        if (info[0] < 7)
+            return false;
+
+        // AVX needs OS support for saving the YMM registers as well as the CPU flag
+        __cpuid(info, 1);
+
+        if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    SimdLevel detectLevel() {
+        SimdLevel supported = SimdLevel::Scalar;
+
+#ifdef STOCKHOUND_X86_64
+        supported = cpuHasAvx2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#endif
+
+        const char* requested = std::getenv("STOCKHOUND_SIMD");
+
+        if (requested == nullptr)
+            return supported;
+
+        SimdLevel level = supported;
+
+        if (std::strcmp(requested, "scalar") == 0)
+            level = SimdLevel::Scalar;
+        else if (std::strcmp(requested, "sse2") == 0)
+            level = SimdLevel::SSE2;
+        else if (std::strcmp(requested, "avx2") == 0)
+            level = SimdLevel::AVX2;
+
+        return std::min(level, supported);
+    }
+
+    AccumulateKernel kernelFor(SimdLevel level) {
+#ifdef STOCKHOUND_X86_64
+        static const bool hasAvx2 = cpuHasAvx2();
+
+        if (level == SimdLevel::AVX2 && hasAvx2)
+            return avx2Accumulate;
+
+        if (level != SimdLevel::Scalar)
+            return sse2Accumulate;
+#else
+        (void)level;
+#endif
+
+        return scalarAccumulate;
+    }
+
+    Indicators computeWith(AccumulateKernel accumulate, std::span<const double> prices, int period) {
+        if (period == 0)
+            period = static_cast<int>(prices.size());
+
+        // Same history rule as StockAnalysis, plus a guard against windows longer than the series
+        if (period <= 0 || prices.size() < static_cast<std::size_t>(period - 10) || prices.size() < static_cast<std::size_t>(period))
+            return {};
+
+        std::span<const double> window = prices.last(static_cast<std::size_t>(period));
+        WindowSums sums;
+        Indicators result;
+
+        sums.Shift = window.front();
+        accumulate(window.data(), window.size(), sums);
+
+        double shiftedMean = sums.Sum / period;
+        result.MovingAverage = sums.Shift + shiftedMean;
+
+        // Population std-dev around the moving average
+        double variance = std::max(sums.SumSquares / period - shiftedMean * shiftedMean, 0.0);
+        double stdDev = std::sqrt(variance);
+        result.UpperBand = result.MovingAverage + IndicatorKernels::numStdDev * stdDev;
+        result.LowerBand = result.MovingAverage - IndicatorKernels::numStdDev * stdDev;
+
+        double avgGain = sums.Gain / period;
+        double avgLoss = sums.Loss / period;
+
+        result.RSI = avgLoss == 0 ? 100.0 : 100.0 - (100.0 / (1.0 + avgGain / avgLoss));
+
+        return result;
+    }
+}
+
+SimdLevel IndicatorKernels::activeLevel() {
+    static const SimdLevel level = detectLevel();
+
+    return level;
+}
+
+const char* IndicatorKernels::levelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+Indicators IndicatorKernels::compute(std::span<const double> prices, int period, SimdLevel level) {
+    return computeWith(kernelFor(level), prices, period);
+}
@@ -0,0 +1,34 @@
+#ifndef INDICATOR_KERNELS_H
+#define INDICATOR_KERNELS_H
+
+#include <span>
+
+// Indicators of one series, every field is -1 when there is not enough history
+struct Indicators {
+    double MovingAverage = -1;
+    double RSI = -1;
+    double UpperBand = -1;
+    double LowerBand = -1;
+};
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Batch versions of the StockAnalysis indicators, computed in one fused pass per window. The pass runs on SSE2 or AVX2
+// when the CPU has them and falls back to a scalar loop otherwise, results match across levels up to summation order.
+class IndicatorKernels {
+public:
+    static constexpr double numStdDev = 2.0;
+
+    // Best level this CPU supports, STOCKHOUND_SIMD=scalar|sse2|avx2 can force a lower one
+    static SimdLevel activeLevel();
+    static const char* levelName(SimdLevel level);
+
+    // Indicators over the last period points of the series, a period of 0 uses the whole series
+    static Indicators compute(std::span<const double> prices, int period, SimdLevel level = activeLevel());
+};
+
+#endif // INDICATOR_KERNELS_H
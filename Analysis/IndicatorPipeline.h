@@ -0,0 +1,340 @@
+#ifndef INDICATOR_PIPELINE_H
+#define INDICATOR_PIPELINE_H
+
+#include "IndicatorKernels.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <tuple>
+
+// One bar as the pipeline hands it to every indicator
+struct BarValues {
+    double Open = 0.0;
+    double High = 0.0;
+    double Low = 0.0;
+    double Close = 0.0;
+    double Volume = 0.0;
+};
+
+// Column views of one symbol's bars, oldest first, the way PriceStore lays them out. Series with only closes are allowed,
+// the other prices then fall back to the close and the volume to zero.
+struct BarSeries {
+    std::span<const double> Opens;
+    std::span<const double> Highs;
+    std::span<const double> Lows;
+    std::span<const double> Closes;
+    std::span<const qint64> Volumes;
+
+    std::size_t size() const {
+        return Closes.size();
+    }
+
+    bool hasOhlcv() const {
+        return Opens.size() == Closes.size() && Highs.size() == Closes.size() && Lows.size() == Closes.size() && Volumes.size() == Closes.size();
+    }
+
+    BarValues bar(std::size_t i) const {
+        if (!hasOhlcv())
+            return BarValues{ Closes[i], Closes[i], Closes[i], Closes[i], 0.0 };
+
+        return BarValues{ Opens[i], Highs[i], Lows[i], Closes[i], static_cast<double>(Volumes[i]) };
+    }
+
+    // count bars starting at offset, both must lie within the series
+    BarSeries subseries(std::size_t offset, std::size_t count) const {
+        auto part = [&](auto column) {
+            return column.size() == Closes.size() ? column.subspan(offset, count) : column.first(0);
+        };
+
+        return BarSeries{ part(Opens), part(Highs), part(Lows), Closes.subspan(offset, count), part(Volumes) };
+    }
+};
+
+// An indicator folds bars in one at a time, oldest first, and says when it has seen enough of them. historyBars is the
+// least number of bars after which it can be ready. State lives in the object itself so a pipeline of them sits on the
+// stack and a symbol costs no allocation.
+template <typename T>
+concept PipelineIndicator = std::default_initializable<T> && requires(T indicator, const T& constIndicator, const BarValues& bar) {
+    indicator.add(bar);
+    { constIndicator.ready() } -> std::convertible_to<bool>;
+    { T::historyBars } -> std::convertible_to<int>;
+};
+
+// Moving average, RSI and Bollinger Bands over every close seen, the same sums and formulas as the IndicatorKernels
+// scalar path
+class WindowStatistics {
+public:
+    static constexpr int historyBars = 10;
+
+    void add(const BarValues& bar) {
+        if (count == 0)
+            shift = previousClose = bar.Close;
+
+        // Branch-free like the kernels, rising and falling closes are a coin flip for the branch predictor
+        double change = bar.Close - previousClose;
+        gain += std::max(change, 0.0);
+        loss += std::max(-change, 0.0);
+
+        double shifted = bar.Close - shift;
+        sum += shifted;
+        sumSquares += shifted * shifted;
+        previousClose = bar.Close;
+        ++count;
+    }
+
+    // Same history rule as StockAnalysis when the period is the whole window
+    bool ready() const {
+        return count >= historyBars;
+    }
+
+    Indicators indicators() const {
+        if (!ready())
+            return {};
+
+        Indicators result;
+        double shiftedMean = sum / count;
+        double stdDev = std::sqrt(std::max(sumSquares / count - shiftedMean * shiftedMean, 0.0));
+        double avgGain = gain / count;
+        double avgLoss = loss / count;
+
+        result.MovingAverage = shift + shiftedMean;
+        result.UpperBand = result.MovingAverage + IndicatorKernels::numStdDev * stdDev;
+        result.LowerBand = result.MovingAverage - IndicatorKernels::numStdDev * stdDev;
+        result.RSI = avgLoss == 0 ? 100.0 : 100.0 - (100.0 / (1.0 + avgGain / avgLoss));
+
+        return result;
+    }
+
+private:
+    double shift = 0.0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    double gain = 0.0;
+    double loss = 0.0;
+    double previousClose = 0.0;
+    int count = 0;
+};
+
+// Exponential moving average of the close, seeded with the first close
+template <int Period>
+class Ema {
+    static_assert(Period > 0);
+
+public:
+    static constexpr double alpha = 2.0 / (Period + 1);
+    static constexpr int historyBars = Period;
+
+    // Only the multiply by the decay and one add depend on the previous bar
+    void add(const BarValues& bar) {
+        average = count == 0 ? bar.Close : average * (1.0 - alpha) + alpha * bar.Close;
+        ++count;
+    }
+
+    bool ready() const {
+        return count >= historyBars;
+    }
+
+    double value() const {
+        return average;
+    }
+
+private:
+    double average = 0.0;
+    int count = 0;
+};
+
+// MACD line, its signal line and the histogram between them
+template <int Fast, int Slow, int Signal>
+class Macd {
+    static_assert(Fast > 0 && Fast < Slow && Signal > 0);
+
+public:
+    // The signal line needs Signal MACD values of its own, the first of them comes with the Slow-th bar
+    static constexpr int historyBars = Slow + Signal - 1;
+
+    void add(const BarValues& bar) {
+        fast.add(bar);
+        slow.add(bar);
+
+        // The signal line is an EMA of the MACD line, fed through the same code as a close. It starts once the slow
+        // average is primed, the line is mostly the seed of the averages before that.
+        if (slow.ready())
+            signal.add(BarValues{ 0.0, 0.0, 0.0, line(), 0.0 });
+    }
+
+    // The signal line has averaged Signal MACD values, before that the histogram is mostly its seed
+    bool ready() const {
+        return signal.ready();
+    }
+
+    double line() const {
+        return fast.value() - slow.value();
+    }
+
+    double signalLine() const {
+        return signal.value();
+    }
+
+    double histogram() const {
+        return line() - signal.value();
+    }
+
+private:
+    Ema<Fast> fast;
+    Ema<Slow> slow;
+    Ema<Signal> signal;
+};
+
+// Average true range with Wilder's smoothing, the first Period true ranges are averaged plainly
+template <int Period>
+class Atr {
+    static_assert(Period > 0);
+
+public:
+    // Multiplying keeps a division out of the dependency chain between bars
+    static constexpr double weight = 1.0 / Period;
+    static constexpr double decay = 1.0 - weight;
+    static constexpr int historyBars = Period;
+
+    void add(const BarValues& bar) {
+        double trueRange = bar.High - bar.Low;
+
+        if (hasPrevious)
+            trueRange = std::max(trueRange, std::max(std::abs(bar.High - previousClose), std::abs(bar.Low - previousClose)));
+
+        if (count < Period)
+            average += trueRange * weight;
+        else
+            average = average * decay + trueRange * weight;
+
+        previousClose = bar.Close;
+        hasPrevious = true;
+        ++count;
+    }
+
+    bool ready() const {
+        return count >= historyBars;
+    }
+
+    double value() const {
+        return average;
+    }
+
+private:
+    double average = 0.0;
+    double previousClose = 0.0;
+    bool hasPrevious = false;
+    int count = 0;
+};
+
+// Volume-weighted average of the typical price, (high + low + close) / 3, over every bar seen
+class Vwap {
+public:
+    static constexpr int historyBars = 1;
+
+    void add(const BarValues& bar) {
+        priceVolume += (bar.High + bar.Low + bar.Close) / 3.0 * bar.Volume;
+        volume += bar.Volume;
+    }
+
+    bool ready() const {
+        return volume > 0.0;
+    }
+
+    double value() const {
+        return priceVolume / volume;
+    }
+
+private:
+    double priceVolume = 0.0;
+    double volume = 0.0;
+};
+
+// Average volume of the newest Recent bars over the average of every bar seen, above 1 when activity is picking up
+template <int Recent>
+class RelativeVolume {
+    static_assert(Recent > 0);
+
+public:
+    static constexpr int historyBars = 2 * Recent;
+
+    void add(const BarValues& bar) {
+        double& slot = recent[static_cast<std::size_t>(count % Recent)];
+
+        recentTotal += bar.Volume - slot;
+        slot = bar.Volume;
+        total += bar.Volume;
+        ++count;
+    }
+
+    // The recent bars have to be a minority of the window for the ratio to mean anything
+    bool ready() const {
+        return count >= historyBars && total > 0.0;
+    }
+
+    double value() const {
+        return (recentTotal / Recent) / (total / count);
+    }
+
+private:
+    std::array<double, Recent> recent{};
+    double recentTotal = 0.0;
+    double total = 0.0;
+    int count = 0;
+};
+
+// Runs every indicator over a series in a single pass, each bar is read once and handed to all of them. The set is fixed
+// at compile time so the calls inline into one loop.
+template <PipelineIndicator... Parts>
+class IndicatorPipeline {
+public:
+    void add(const BarValues& bar) {
+        std::apply([&](Parts&... part) { (part.add(bar), ...); }, parts);
+    }
+
+    void run(const BarSeries& bars) {
+        // The columns are doubles too, so writes to members could alias them and every running value would go through
+        // memory. Each indicator is copied into its own local whose address never escapes, which the compiler keeps in
+        // registers for the whole loop.
+        std::apply([&](Parts... local) {
+            // Which columns exist is decided once, the loop itself only reads
+            if (bars.hasOhlcv()) {
+                for (std::size_t i = 0; i < bars.size(); ++i) {
+                    const BarValues bar{ bars.Opens[i], bars.Highs[i], bars.Lows[i], bars.Closes[i], static_cast<double>(bars.Volumes[i]) };
+
+                    (local.add(bar), ...);
+                }
+            } else {
+                for (double close : bars.Closes) {
+                    const BarValues bar{ close, close, close, close, 0.0 };
+
+                    (local.add(bar), ...);
+                }
+            }
+
+            parts = std::tuple<Parts...>(local...);
+        }, parts);
+    }
+
+    template <typename T>
+    const T& get() const {
+        return std::get<T>(parts);
+    }
+
+private:
+    std::tuple<Parts...> parts;
+};
+
+// Stages StockAnalysis weighs on top of the window statistics, a pass only includes the ones with a weight. A new
+// indicator goes in here, in ScoreWeights and in the weighting in StockAnalysis.
+using OptionalStages = std::tuple<Ema<20>, Macd<12, 26, 9>, Atr<14>, Vwap, RelativeVolume<5>>;
+
+// Everything StockAnalysis can weigh, in one pipeline
+using ScoringPipeline = IndicatorPipeline<WindowStatistics, Ema<20>, Macd<12, 26, 9>, Atr<14>, Vwap, RelativeVolume<5>>;
+
+#endif // INDICATOR_PIPELINE_H
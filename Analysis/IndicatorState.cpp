@@ -0,0 +1,133 @@
+#include "IndicatorState.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <algorithm>
+#include <cmath>
+
+IndicatorState IndicatorState::fromSeries(std::span<const double> closes, qint64 lastTimestamp) {
+    IndicatorState state;
+
+    if (closes.empty())
+        return state;
+
+    for (double close : closes)
+        state.push(close, 0);
+
+    state.LastTimestamp = lastTimestamp;
+
+    return state;
+}
+
+void IndicatorState::push(double close, qint64 timestamp) {
+    // Sums stay small numbers around the first close, so the variance does not lose precision to cancellation
+    if (Count == 0) {
+        Shift = close;
+    } else {
+        double change = close - LastClose;
+
+        if (change > 0) {
+            GainSum += change;
+        } else {
+            LossSum -= change;
+
+            if (change < 0)
+                ++DownMoves;
+        }
+    }
+
+    double shifted = close - Shift;
+
+    ++Count;
+    Sum += shifted;
+    SumSquares += shifted * shifted;
+    LastClose = close;
+    LastTimestamp = timestamp;
+}
+
+void IndicatorState::pop(double oldest, double next) {
+    if (Count <= 1) {
+        *this = IndicatorState{};
+
+        return;
+    }
+
+    double change = next - oldest;
+
+    if (change > 0) {
+        GainSum = std::max(GainSum - change, 0.0);
+    } else {
+        LossSum = std::max(LossSum + change, 0.0);
+
+        if (change < 0)
+            --DownMoves;
+    }
+
+    double shifted = oldest - Shift;
+
+    --Count;
+    Sum -= shifted;
+    SumSquares -= shifted * shifted;
+}
+
+void IndicatorState::slide(double oldest, double next, double close, qint64 timestamp) {
+    push(close, timestamp);
+    pop(oldest, next);
+}
+
+Indicators IndicatorState::indicators() const {
+    // Same history rule as StockAnalysis when the period is the whole window
+    if (Count < 10)
+        return {};
+
+    Indicators result;
+    double period = Count;
+
+    double mean = Sum / period;
+
+    result.MovingAverage = Shift + mean;
+
+    // Population std-dev from the shifted sums, rounding can push a flat window's variance just below zero
+    double variance = std::max(SumSquares / period - mean * mean, 0.0);
+    double stdDev = std::sqrt(variance);
+    result.UpperBand = result.MovingAverage + IndicatorKernels::numStdDev * stdDev;
+    result.LowerBand = result.MovingAverage - IndicatorKernels::numStdDev * stdDev;
+
+    if (DownMoves == 0) {
+        result.RSI = 100.0;
+    } else {
+        double rs = (GainSum / period) / (LossSum / period);
+        result.RSI = 100.0 - (100.0 / (1.0 + rs));
+    }
+
+    return result;
+}
+
+bool IndicatorState::loadAll(QSqlDatabase& db, std::unordered_map<std::string, IndicatorState>& states, QString& errorMessage) {
+    QSqlQuery stateQuery(db);
+
+    stateQuery.setForwardOnly(true);
+
+    if (!stateQuery.exec("SELECT symbol, last_timestamp, count, shift, sum, sum_squares, gain_sum, loss_sum, down_moves, last_close FROM indicator_state")) {
+        errorMessage = "Query execution failed:" + stateQuery.lastError().text();
+
+        return false;
+    }
+
+    while (stateQuery.next()) {
+        IndicatorState& state = states[stateQuery.value(0).toString().toStdString()];
+
+        state.LastTimestamp = stateQuery.value(1).toLongLong();
+        state.Count = stateQuery.value(2).toInt();
+        state.Shift = stateQuery.value(3).toDouble();
+        state.Sum = stateQuery.value(4).toDouble();
+        state.SumSquares = stateQuery.value(5).toDouble();
+        state.GainSum = stateQuery.value(6).toDouble();
+        state.LossSum = stateQuery.value(7).toDouble();
+        state.DownMoves = stateQuery.value(8).toInt();
+        state.LastClose = stateQuery.value(9).toDouble();
+    }
+
+    return true;
+}
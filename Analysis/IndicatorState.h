@@ -0,0 +1,45 @@
+#ifndef INDICATOR_STATE_H
+#define INDICATOR_STATE_H
+
+#include "IndicatorKernels.h"
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QtGlobal>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+// Running sums over a symbol's close window so a new bar updates the indicators in O(1) instead of rescanning the window.
+// Uses the StockAnalysis formulas with the whole window as the period, the same way the scan scores.
+class IndicatorState {
+public:
+    qint64 LastTimestamp = 0;
+    int Count = 0;
+    double Shift = 0.0;       // Sums are of close - Shift, the oldest close when the window was built, like the batch kernels
+    double Sum = 0.0;
+    double SumSquares = 0.0;
+    double GainSum = 0.0;  // Upward moves between consecutive closes in the window
+    double LossSum = 0.0;  // Downward moves, as a positive number
+    int DownMoves = 0;     // Keeps "no losses" exact after many subtractions
+    double LastClose = 0.0;
+
+    // Builds the state for a window of closes, oldest first. Rebuilding re-centres the shift on the current window.
+    static IndicatorState fromSeries(std::span<const double> closes, qint64 lastTimestamp);
+
+    // Appends a new newest bar, the window grows by one
+    void push(double close, qint64 timestamp);
+
+    // Drops the oldest close, next is the close that follows it and becomes the oldest
+    void pop(double oldest, double next);
+
+    // Moves a fixed-size window forward by one bar
+    void slide(double oldest, double next, double close, qint64 timestamp);
+
+    Indicators indicators() const;
+
+    // Every stored state, keyed by symbol
+    static bool loadAll(QSqlDatabase& db, std::unordered_map<std::string, IndicatorState>& states, QString& errorMessage);
+};
+
+#endif // INDICATOR_STATE_H
@@ -0,0 +1,111 @@
+#include "ParallelScorer.h"
+#include "PriceStore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace {
+    // One thread's share of the symbols, the owner and thieves both claim chunks from the front
+    struct alignas(64) WorkRange {
+        std::atomic<std::size_t> next{0};
+        std::size_t end = 0;
+    };
+}
+
+ParallelScorer::ParallelScorer(unsigned threadLimit)
+    : threads(threadLimit != 0 ? threadLimit : std::max(1u, std::thread::hardware_concurrency())) {}
+
+unsigned ParallelScorer::threadCount() const {
+    return threads;
+}
+
+const ParallelScorerStats& ParallelScorer::stats() const {
+    return lastStats;
+}
+
+void ParallelScorer::score(const PriceStore& store, std::span<const double> prices, std::vector<ScoreCard>& scores, const ScoreWeights& weights) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::size_t symbolCount = std::min(store.symbolCount(), prices.size());
+    SimdLevel level = IndicatorKernels::activeLevel();
+    bool usesBars = weights.usesBars();
+
+    scores.assign(symbolCount, ScoreCard{});
+
+    // Small universes are not worth starting threads for
+    unsigned workerCount = static_cast<unsigned>(std::min<std::size_t>(threads, (symbolCount + chunkSize - 1) / chunkSize));
+    workerCount = std::max(1u, workerCount);
+
+    std::unique_ptr<WorkRange[]> ranges(new WorkRange[workerCount]);
+
+    for (unsigned i = 0; i < workerCount; ++i) {
+        ranges[i].next.store(symbolCount * i / workerCount, std::memory_order_relaxed);
+        ranges[i].end = symbolCount * (i + 1) / workerCount;
+    }
+
+    std::atomic<std::size_t> chunks{0};
+    std::atomic<std::size_t> stolenChunks{0};
+
+    auto scoreRange = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (usesBars)
+                scores[i] = StockAnalysis::calculateTotalScores(prices[i], store.series(i), weights);
+            else
+                scores[i] = StockAnalysis::calculateTotalScores(prices[i], IndicatorKernels::compute(store.closes(i), 0, level), weights);
+        }
+    };
+
+    auto claim = [&](WorkRange& range, std::size_t& begin, std::size_t& end) {
+        // Claims past the end are harmless, they just find nothing left
+        begin = range.next.fetch_add(chunkSize, std::memory_order_relaxed);
+
+        if (begin >= range.end)
+            return false;
+
+        end = std::min(begin + chunkSize, range.end);
+
+        return true;
+    };
+
+    auto work = [&](unsigned self) {
+        std::size_t begin, end;
+        std::size_t ownChunks = 0;
+        std::size_t stolen = 0;
+
+        while (claim(ranges[self], begin, end)) {
+            scoreRange(begin, end);
+            ++ownChunks;
+        }
+
+        // Own range is done, help whoever still has work
+        for (unsigned offset = 1; offset < workerCount; ++offset) {
+            WorkRange& victim = ranges[(self + offset) % workerCount];
+
+            while (claim(victim, begin, end)) {
+                scoreRange(begin, end);
+                ++stolen;
+            }
+        }
+
+        chunks.fetch_add(ownChunks + stolen, std::memory_order_relaxed);
+        stolenChunks.fetch_add(stolen, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+
+    for (unsigned i = 1; i < workerCount; ++i)
+        workers.emplace_back(work, i);
+
+    work(0);
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    lastStats.Threads = workerCount;
+    lastStats.Chunks = chunks.load();
+    lastStats.StolenChunks = stolenChunks.load();
+    lastStats.ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
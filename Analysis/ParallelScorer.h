@@ -0,0 +1,43 @@
+#ifndef PARALLEL_SCORER_H
+#define PARALLEL_SCORER_H
+
+#include "StockAnalysis.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+class PriceStore;
+
+struct ParallelScorerStats {
+    unsigned Threads = 0;
+    std::size_t Chunks = 0;
+    std::size_t StolenChunks = 0;  // Chunks a thread took from another thread's range
+    double ElapsedMs = 0.0;
+};
+
+// Scores a whole universe on every core. Each thread starts on its own slice of the symbols and steals chunks from the
+// others once it runs dry, so uneven window lengths do not leave cores idle. Nothing here touches the database, the
+// caller writes the results from one thread.
+class ParallelScorer {
+public:
+    // Symbols handed out per claim, small enough to balance and large enough to keep the atomics cold
+    static constexpr std::size_t chunkSize = 64;
+
+    // Zero threads uses every hardware thread
+    explicit ParallelScorer(unsigned threads = 0);
+
+    // Scores symbol i of the store against prices[i], the results line up with the store's symbol indexes. Close-only
+    // weights run the SIMD kernels, weights that use full bars run a pipeline of the weighted stages instead.
+    void score(const PriceStore& store, std::span<const double> prices, std::vector<ScoreCard>& scores,
+               const ScoreWeights& weights = ScoreWeights());
+
+    unsigned threadCount() const;
+    const ParallelScorerStats& stats() const;
+
+private:
+    unsigned threads;
+    ParallelScorerStats lastStats;
+};
+
+#endif // PARALLEL_SCORER_H
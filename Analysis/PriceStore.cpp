@@ -0,0 +1,239 @@
+#include "PriceStore.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <algorithm>
+
+bool PriceStore::load(QSqlDatabase& db, QString& errorMessage, qint64 since, qint64 until) {
+    QSqlQuery historyQuery(db);
+
+    clear();
+
+    // The table is clustered on (symbol, timestamp), so this ordering is a plain sequential read without a sort
+    historyQuery.setForwardOnly(true);
+    historyQuery.prepare("SELECT symbol, timestamp, open, high, low, close, volume FROM historical_data "
+                         "WHERE timestamp >= :since AND timestamp <= :until ORDER BY symbol, timestamp");
+    historyQuery.bindValue(":since", since);
+    historyQuery.bindValue(":until", until);
+
+    if (!historyQuery.exec()) {
+        errorMessage = "Failed to load price history: " + historyQuery.lastError().text();
+
+        return false;
+    }
+
+    readRows(historyQuery);
+
+    return true;
+}
+
+bool PriceStore::loadRollups(QSqlDatabase& db, Timeframe timeframe, QString& errorMessage, qint64 since, qint64 until) {
+    if (timeframe == Timeframe::Day)
+        return load(db, errorMessage, since, until);
+
+    // The cache stores daily bars, nothing finer can be derived from them
+    if (timeframe < Timeframe::Day) {
+        errorMessage = QString("No %1 bars are cached, the finest cached timeframe is 1Day").arg(BarAggregator::timeframeName(timeframe));
+
+        return false;
+    }
+
+    QSqlQuery rollupQuery(db);
+
+    clear();
+
+    // Same clustering as historical_data, with the timeframe between symbol and timestamp
+    rollupQuery.setForwardOnly(true);
+    rollupQuery.prepare("SELECT symbol, timestamp, open, high, low, close, volume FROM bar_rollups "
+                        "WHERE timeframe = :timeframe AND timestamp >= :since AND timestamp <= :until ORDER BY symbol, timestamp");
+    rollupQuery.bindValue(":timeframe", QString(BarAggregator::timeframeName(timeframe)));
+    rollupQuery.bindValue(":since", since);
+    rollupQuery.bindValue(":until", until);
+
+    if (!rollupQuery.exec()) {
+        errorMessage = QString("Failed to load %1 bars: %2").arg(BarAggregator::timeframeName(timeframe)).arg(rollupQuery.lastError().text());
+
+        return false;
+    }
+
+    readRows(rollupQuery);
+
+    return true;
+}
+
+// Rows are symbol, timestamp, open, high, low, close, volume, grouped by symbol and oldest first
+void PriceStore::readRows(QSqlQuery& rowsQuery) {
+    QString currentSymbol;
+    bool hasSymbol = false;
+
+    while (rowsQuery.next()) {
+        QString rowSymbol = rowsQuery.value(0).toString();
+
+        if (!hasSymbol || rowSymbol != currentSymbol) {
+            if (hasSymbol)
+                endSymbol();
+
+            currentSymbol = rowSymbol;
+            hasSymbol = true;
+            beginSymbol(currentSymbol.toStdString());
+        }
+
+        pushBar(rowsQuery.value(1).toLongLong(),
+                rowsQuery.value(2).toDouble(),
+                rowsQuery.value(3).toDouble(),
+                rowsQuery.value(4).toDouble(),
+                rowsQuery.value(5).toDouble(),
+                rowsQuery.value(6).toLongLong());
+    }
+
+    if (hasSymbol)
+        endSymbol();
+}
+
+void PriceStore::rollUp(const PriceStore& source, Timeframe timeframe) {
+    BarAggregator aggregator(timeframe);
+    std::vector<RollupBar> rollups;
+
+    clear();
+
+    for (std::size_t i = 0; i < source.symbolCount(); ++i) {
+        std::size_t begin = source.offsets[i];
+        std::size_t end = source.offsets[i + 1];
+
+        aggregator.reset();
+        rollups.clear();
+
+        for (std::size_t bar = begin; bar < end; ++bar) {
+            aggregator.add(BarData{ source.timestampColumn[bar], source.openColumn[bar], source.highColumn[bar], source.lowColumn[bar],
+                                    source.closeValues[bar], source.volumeColumn[bar] });
+        }
+
+        aggregator.drain(rollups);
+
+        if (rollups.empty())
+            continue;
+
+        beginSymbol(source.symbols[i]);
+
+        for (const RollupBar& rollup : rollups)
+            pushBar(rollup.Timestamp, rollup.Open, rollup.High, rollup.Low, rollup.Close, rollup.Volume);
+
+        endSymbol();
+    }
+}
+
+void PriceStore::clear() {
+    symbols.clear();
+    symbolIndex.clear();
+    offsets.assign(1, 0);
+    timestampColumn.clear();
+    openColumn.clear();
+    highColumn.clear();
+    lowColumn.clear();
+    closeValues.clear();
+    volumeColumn.clear();
+}
+
+void PriceStore::reserve(std::size_t symbolCapacity, std::size_t barCapacity) {
+    symbols.reserve(symbolCapacity);
+    symbolIndex.reserve(symbolCapacity);
+    offsets.reserve(symbolCapacity + 1);
+    timestampColumn.reserve(barCapacity);
+    openColumn.reserve(barCapacity);
+    highColumn.reserve(barCapacity);
+    lowColumn.reserve(barCapacity);
+    closeValues.reserve(barCapacity);
+    volumeColumn.reserve(barCapacity);
+}
+
+void PriceStore::append(const std::string& symbol, std::span<const BarData> bars) {
+    beginSymbol(symbol);
+
+    for (const BarData& bar : bars)
+        pushBar(bar.Timestamp, bar.Open, bar.High, bar.Low, bar.Close, bar.Volume);
+
+    endSymbol();
+}
+
+void PriceStore::beginSymbol(const std::string& symbol) {
+    symbolIndex.emplace(symbol, symbols.size());
+    symbols.push_back(symbol);
+}
+
+void PriceStore::pushBar(qint64 timestamp, double open, double high, double low, double close, qint64 volume) {
+    timestampColumn.push_back(timestamp);
+    openColumn.push_back(open);
+    highColumn.push_back(high);
+    lowColumn.push_back(low);
+    closeValues.push_back(close);
+    volumeColumn.push_back(volume);
+}
+
+void PriceStore::endSymbol() {
+    offsets.push_back(closeValues.size());
+}
+
+std::size_t PriceStore::symbolCount() const {
+    return symbols.size();
+}
+
+std::size_t PriceStore::barCount() const {
+    return closeValues.size();
+}
+
+std::size_t PriceStore::indexOf(const std::string& symbol) const {
+    auto it = symbolIndex.find(symbol);
+
+    return it == symbolIndex.end() ? npos : it->second;
+}
+
+const std::string& PriceStore::symbol(std::size_t index) const {
+    return symbols[index];
+}
+
+std::size_t PriceStore::size(std::size_t index) const {
+    return offsets[index + 1] - offsets[index];
+}
+
+std::span<const qint64> PriceStore::timestamps(std::size_t index) const {
+    return slice(timestampColumn, index);
+}
+
+std::span<const double> PriceStore::opens(std::size_t index) const {
+    return slice(openColumn, index);
+}
+
+std::span<const double> PriceStore::highs(std::size_t index) const {
+    return slice(highColumn, index);
+}
+
+std::span<const double> PriceStore::lows(std::size_t index) const {
+    return slice(lowColumn, index);
+}
+
+std::span<const double> PriceStore::closes(std::size_t index) const {
+    return slice(closeValues, index);
+}
+
+std::span<const qint64> PriceStore::volumes(std::size_t index) const {
+    return slice(volumeColumn, index);
+}
+
+BarSeries PriceStore::series(std::size_t index) const {
+    return BarSeries{ opens(index), highs(index), lows(index), closes(index), volumes(index) };
+}
+
+std::span<const double> PriceStore::recentCloses(std::size_t index, std::size_t count) const {
+    std::span<const double> all = closes(index);
+
+    return all.last(std::min(count, all.size()));
+}
+
+const std::vector<std::size_t>& PriceStore::symbolOffsets() const {
+    return offsets;
+}
+
+const std::vector<double>& PriceStore::closeColumn() const {
+    return closeValues;
+}
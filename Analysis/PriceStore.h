@@ -0,0 +1,89 @@
+#ifndef PRICE_STORE_H
+#define PRICE_STORE_H
+
+#include "BarAggregator.h"
+#include "Core/MarketData.h"
+#include "IndicatorPipeline.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Structure-of-arrays OHLCV for a whole universe. Each column is one contiguous array and a symbol's bars are the
+// slice [offsets[i], offsets[i + 1]), oldest first, so analysis code gets spans without copies or queries.
+class PriceStore {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    // Replaces the contents with every bar in [since, until] using one sequential query over historical_data
+    bool load(QSqlDatabase& db, QString& errorMessage, qint64 since = 0, qint64 until = std::numeric_limits<qint64>::max());
+
+    // The same for one timeframe, weeks and months come from bar_rollups and are stamped with the start of their bucket.
+    // Days read historical_data as load() does, anything finer is an error.
+    bool loadRollups(QSqlDatabase& db, Timeframe timeframe, QString& errorMessage, qint64 since = 0,
+                     qint64 until = std::numeric_limits<qint64>::max());
+
+    // Replaces the contents with source's bars rolled up to a coarser timeframe, for bars that did not come from the cache
+    void rollUp(const PriceStore& source, Timeframe timeframe);
+
+    void clear();
+    void reserve(std::size_t symbolCapacity, std::size_t barCapacity);
+
+    // Bars must be oldest first, appending a symbol that is already present is not supported
+    void append(const std::string& symbol, std::span<const BarData> bars);
+
+    std::size_t symbolCount() const;
+    std::size_t barCount() const;
+
+    // Index of the symbol, npos if it has no bars
+    std::size_t indexOf(const std::string& symbol) const;
+    const std::string& symbol(std::size_t index) const;
+    std::size_t size(std::size_t index) const;
+
+    std::span<const qint64> timestamps(std::size_t index) const;
+    std::span<const double> opens(std::size_t index) const;
+    std::span<const double> highs(std::size_t index) const;
+    std::span<const double> lows(std::size_t index) const;
+    std::span<const double> closes(std::size_t index) const;
+    std::span<const qint64> volumes(std::size_t index) const;
+
+    // Every column of a symbol at once, for the ScoringPipeline
+    BarSeries series(std::size_t index) const;
+
+    // The newest count closes of a symbol, or all of them if it has fewer
+    std::span<const double> recentCloses(std::size_t index, std::size_t count) const;
+
+    // Whole columns, for kernels that walk every symbol at once
+    const std::vector<std::size_t>& symbolOffsets() const;
+    const std::vector<double>& closeColumn() const;
+
+private:
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, std::size_t> symbolIndex;
+    std::vector<std::size_t> offsets{0};
+
+    std::vector<qint64> timestampColumn;
+    std::vector<double> openColumn;
+    std::vector<double> highColumn;
+    std::vector<double> lowColumn;
+    std::vector<double> closeValues;
+    std::vector<qint64> volumeColumn;
+
+    void readRows(QSqlQuery& rowsQuery);
+    void beginSymbol(const std::string& symbol);
+    void pushBar(qint64 timestamp, double open, double high, double low, double close, qint64 volume);
+    void endSymbol();
+
+    template <typename T>
+    std::span<const T> slice(const std::vector<T>& column, std::size_t index) const {
+        return std::span<const T>(column.data() + offsets[index], offsets[index + 1] - offsets[index]);
+    }
+};
+
+#endif // PRICE_STORE_H
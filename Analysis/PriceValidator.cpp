@@ -1,139 +1,215 @@
 #include "PriceValidator.h"
-#include "StockAnalysis.h"
-#include "iostream"
-#include <QSqlQuery>
+#include "IndicatorPipeline.h"
+
 #include <QSqlError>
 #include <QVariant>
+#include <QVariantList>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
 
 // Constructor
 PriceValidator::PriceValidator(QSqlDatabase& database) : db(database) {}
 
-// Public method to validate and correct trade prices
-void PriceValidator::validateAndCorrectPrices() const {
-    QSqlQuery query(db);
+const QString& PriceValidator::lastError() const {
+    return errorMessage;
+}
 
-    // Fetch all trades
-    if (!query.exec("SELECT symbol, price FROM trades")) {
-        std::cerr << "Error fetching trades: " << query.lastError().text().toStdString() << std::endl;
+const PriceValidationStats& PriceValidator::stats() const {
+    return validationStats;
+}
 
-        return;
-    }
+bool PriceValidator::fail(const QSqlQuery& query) {
+    errorMessage = "Query execution failed:" + query.lastError().text();
 
-    while (query.next()) {
-        QString symbol = query.value("symbol").toString();
-        double tradePrice = query.value("price").toDouble();
+    return false;
+}
 
-        // Get the latest closing price
-        double latestClose = getLatestClosingPrice(symbol);
+bool PriceValidator::run(const PriceValidationOptions& options) {
+    auto started = std::chrono::steady_clock::now();
 
-        // If there's a significant discrepancy, update the trade price
-        if (latestClose > 0 && std::abs(tradePrice - latestClose) / latestClose > 0.005)  // 0.5% tolerance
-            updateTradePrice(symbol, latestClose);
-    }
-}
+    validationStats = PriceValidationStats();
+    errorMessage.clear();
+
+    if (!db.transaction()) {
+        errorMessage = "Failed to start transaction: " + db.lastError().text();
 
-// Public method to double-check all total scores >=0.80 against their historical data then recalculate their scores
-void PriceValidator::revalidateSuspiciousScores() const {
-    QSqlQuery query(db);
+        return false;
+    }
 
-    // Step 1: Identify all stocks with total_score >= 1
-    if (!query.exec("SELECT symbol, total_score FROM scores WHERE total_score >= 0.80")) {
-        std::cerr << "Failed to fetch suspicious scores: " << query.lastError().text().toStdString() << std::endl;
+    // Prices first, so recomputed scores already use the corrected ones
+    if (!correctPrices(options) || !revalidateScores(options)) {
+        db.rollback();
+        validationStats = PriceValidationStats();
 
-        return;
+        return false;
     }
 
-    while (query.next()) {
-        QString symbol = query.value("symbol").toString();
-        double totalScore = query.value("total_score").toDouble();
+    if (!db.commit()) {
+        errorMessage = "Failed to commit transaction: " + db.lastError().text();
+        db.rollback();
+        validationStats = PriceValidationStats();
 
-        // Step 2: Fetch the historical data for this stock
-        QSqlQuery historicalQuery(db);
+        return false;
+    }
 
-        historicalQuery.prepare("SELECT close FROM historical_data WHERE symbol = :symbol ORDER BY timestamp DESC LIMIT 30");
-        historicalQuery.bindValue(":symbol", symbol);
+    validationStats.ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
 
-        if (!historicalQuery.exec()) {
-            std::cerr << "Failed to fetch historical data for " << symbol.toStdString() << ":" << historicalQuery.lastError().text().toStdString() << std::endl;
+    return true;
+}
 
-            continue;
-        }
+bool PriceValidator::correctPrices(const PriceValidationOptions& options) {
+    QSqlQuery correctQuery(db);
 
-        std::vector<double> priceHistory;
+    // The newest close is one seek on the (symbol, timestamp) key. Symbols without bars or with a zero close compare
+    // as NULL and are left alone, so are trades fetched after the newest bar ended, e.g. the ones a scan just wrote.
+    correctQuery.prepare("UPDATE trades SET price = "
+                         "(SELECT close FROM historical_data WHERE historical_data.symbol = trades.symbol ORDER BY timestamp DESC LIMIT 1) "
+                         "WHERE ABS(price / (SELECT NULLIF(close, 0) FROM historical_data WHERE historical_data.symbol = trades.symbol "
+                         "ORDER BY timestamp DESC LIMIT 1) - 1.0) > :tolerance "
+                         "AND (SELECT MAX(last_updated) FROM stocks WHERE stocks.symbol = trades.symbol) < "
+                         "(SELECT MAX(timestamp) FROM historical_data WHERE historical_data.symbol = trades.symbol) + :barSeconds");
+    correctQuery.bindValue(":tolerance", options.priceTolerance);
+    correctQuery.bindValue(":barSeconds", options.barSeconds);
 
-        while (historicalQuery.next())
-            priceHistory.push_back(historicalQuery.value("close").toDouble());
+    if (!correctQuery.exec())
+        return fail(correctQuery);
 
-        // Step 3: Fetch the latest trade price
-        QSqlQuery tradeQuery(db);
+    validationStats.PricesCorrected = correctQuery.numRowsAffected();
 
-        tradeQuery.prepare("SELECT price FROM trades WHERE symbol = :symbol LIMIT 1");
-        tradeQuery.bindValue(":symbol", symbol);
+    return true;
+}
 
-        if (!tradeQuery.exec() || !tradeQuery.next()) {
-            std::cerr << "Failed to fetch trade price for " << symbol.toStdString() << ":" << tradeQuery.lastError().text().toStdString() << std::endl;
+bool PriceValidator::revalidateScores(const PriceValidationOptions& options) {
+    QSqlQuery windowQuery(db);
+
+    // A window shorter than the weighted indicators need would exclude every symbol it checks
+    const int window = std::max(options.windowBars, options.weights.historyBars());
+
+    // Only the newest windowBars bars of each suspicious symbol are read, oldest first. A symbol without bars still
+    // comes back once with a NULL close so it can be excluded.
+    windowQuery.setForwardOnly(true);
+    windowQuery.prepare("SELECT symbol, total_score, price, open, high, low, close, volume FROM ("
+                        "SELECT scores.symbol, scores.total_score, trades.price, historical_data.timestamp, historical_data.open, "
+                        "historical_data.high, historical_data.low, historical_data.close, historical_data.volume, "
+                        "ROW_NUMBER() OVER (PARTITION BY scores.symbol ORDER BY historical_data.timestamp DESC) AS age "
+                        "FROM scores "
+                        "JOIN trades ON trades.symbol = scores.symbol "
+                        "LEFT JOIN historical_data ON historical_data.symbol = scores.symbol "
+                        "WHERE scores.total_score >= :threshold) "
+                        "WHERE age <= :window "
+                        "ORDER BY symbol, timestamp");
+    windowQuery.bindValue(":threshold", options.suspiciousScore);
+    windowQuery.bindValue(":window", window);
+
+    if (!windowQuery.exec())
+        return fail(windowQuery);
+
+    QVariantList updateSymbols, maScores, rsiScores, bbScores, totalScores;
+    QVariantList excludeSymbols;
+    std::vector<double> opens, highs, lows, closes;
+    std::vector<qint64> volumes;
+    QString symbol;
+    double storedScore = 0.0;
+    double price = 0.0;
+
+    // Reused for every symbol, so only the first one allocates
+    const std::size_t windowCapacity = static_cast<std::size_t>(window);
+
+    opens.reserve(windowCapacity);
+    highs.reserve(windowCapacity);
+    lows.reserve(windowCapacity);
+    closes.reserve(windowCapacity);
+    volumes.reserve(windowCapacity);
+
+    auto finishSymbol = [&]() {
+        ++validationStats.ScoresChecked;
+
+        ScoreCard scores = StockAnalysis::calculateTotalScores(price, BarSeries{ opens, highs, lows, closes, volumes }, options.weights);
+
+        // Not enough history, exclude the symbol
+        if (!scores.Valid) {
+            excludeSymbols << symbol;
+
+            return;
+        }
 
-            continue;
+        if (std::abs(scores.Total_Score - storedScore) > options.scoreTolerance) {
+            updateSymbols << symbol;
+            maScores << scores.MA_Score;
+            rsiScores << scores.RSI_Score;
+            bbScores << scores.BB_Score;
+            totalScores << scores.Total_Score;
+        }
+    };
+
+    while (windowQuery.next()) {
+        QString rowSymbol = windowQuery.value(0).toString();
+
+        if (rowSymbol != symbol) {
+            if (!symbol.isEmpty())
+                finishSymbol();
+
+            symbol = rowSymbol;
+            storedScore = windowQuery.value(1).toDouble();
+            price = windowQuery.value(2).toDouble();
+            opens.clear();
+            highs.clear();
+            lows.clear();
+            closes.clear();
+            volumes.clear();
         }
 
-        double tradePrice = tradeQuery.value("price").toDouble();
-
-        // Step 4: Recalculate the scores using available historical data
-        try {
-            std::vector<double> recalculatedScores = StockAnalysis::calculateTotalScores(tradePrice, priceHistory, priceHistory.size());
-            double recalculatedTotalScore = recalculatedScores[3];
-
-            // Step 5: Compare and update the scores if necessary
-            if (std::abs(recalculatedTotalScore - totalScore) > 0.05) { // Threshold for revalidation
-                QSqlQuery updateQuery(db);
-
-                updateQuery.prepare("UPDATE scores SET ma_score = :ma_score, rsi_score = :rsi_score, bb_score = :bb_score, total_score = :total_score WHERE symbol = :symbol");
-                updateQuery.bindValue(":ma_score", recalculatedScores[0]);
-                updateQuery.bindValue(":rsi_score", recalculatedScores[1]);
-                updateQuery.bindValue(":bb_score", recalculatedScores[2]);
-                updateQuery.bindValue(":total_score", recalculatedScores[3]);
-                updateQuery.bindValue(":symbol", symbol);
-
-                if (!updateQuery.exec())
-                    std::cerr << "Failed to update scores for " << symbol.toStdString() << ":" << updateQuery.lastError().text().toStdString() << std::endl;
-                else
-                    std::cout << "Revalidated and updated scores for " << symbol.toStdString() << std::endl;
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error recalculating scores for " << symbol.toStdString() << ": " << e.what() << std::endl;
+        if (!windowQuery.value(6).isNull()) {
+            opens.push_back(windowQuery.value(3).toDouble());
+            highs.push_back(windowQuery.value(4).toDouble());
+            lows.push_back(windowQuery.value(5).toDouble());
+            closes.push_back(windowQuery.value(6).toDouble());
+            volumes.push_back(windowQuery.value(7).toLongLong());
         }
     }
-}
 
-// Private helper method to fetch the latest closing price for a stock
-double PriceValidator::getLatestClosingPrice(const QString& symbol) const {
-    QSqlQuery query(db);
+    if (!symbol.isEmpty())
+        finishSymbol();
+
+    if (!updateSymbols.isEmpty()) {
+        QSqlQuery updateQuery(db);
 
-    query.prepare("SELECT close FROM historical_data WHERE symbol = :symbol ORDER BY timestamp DESC LIMIT 1");
-    query.bindValue(":symbol", symbol);
+        updateQuery.prepare("UPDATE scores SET ma_score = ?, rsi_score = ?, bb_score = ?, total_score = ? WHERE symbol = ?");
+        updateQuery.addBindValue(maScores);
+        updateQuery.addBindValue(rsiScores);
+        updateQuery.addBindValue(bbScores);
+        updateQuery.addBindValue(totalScores);
+        updateQuery.addBindValue(updateSymbols);
 
-    if (!query.exec()) {
-        std::cerr << "Error fetching latest closing price for " << symbol.toStdString() << ": " << query.lastError().text().toStdString() << std::endl;
+        if (!updateQuery.execBatch())
+            return fail(updateQuery);
 
-        return -1;
+        validationStats.ScoresUpdated = static_cast<int>(updateSymbols.size());
     }
 
-    if (query.next())
-        return query.value("close").toDouble();
+    if (!excludeSymbols.isEmpty()) {
+        QSqlQuery excludeQuery(db);
 
-    return -1; // No data found
-}
+        excludeQuery.prepare("UPDATE stocks SET excluded = 1 WHERE symbol = ?");
+        excludeQuery.addBindValue(excludeSymbols);
+
+        if (!excludeQuery.execBatch())
+            return fail(excludeQuery);
+
+        validationStats.SymbolsExcluded = static_cast<int>(excludeSymbols.size());
+    }
+
+    // Recomputed scores may now reach the ceiling a scan would have excluded them at
+    QSqlQuery ceilingQuery(db);
 
-// Private helper method to update a trade price in the trades table
-void PriceValidator::updateTradePrice(const QString& symbol, double correctedPrice) const {
-    QSqlQuery query(db);
+    ceilingQuery.prepare("UPDATE stocks SET excluded = 1 WHERE excluded = 0 AND symbol IN "
+                         "(SELECT symbol FROM scores WHERE total_score >= :ceiling)");
+    ceilingQuery.bindValue(":ceiling", options.scoreCeiling);
 
-    query.prepare("UPDATE trades SET price = :price WHERE symbol = :symbol");
-    query.bindValue(":price", correctedPrice);
-    query.bindValue(":symbol", symbol);
+    if (!ceilingQuery.exec())
+        return fail(ceilingQuery);
 
-    if (!query.exec())
-        std::cerr << "Error updating trade price for " << symbol.toStdString() << ": " << query.lastError().text().toStdString() << std::endl;
-    else
-        std::cout << "Updated trade price for " << symbol.toStdString() << " to " << correctedPrice << std::endl;
+    return true;
 }
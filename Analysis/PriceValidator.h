@@ -1,23 +1,54 @@
 #ifndef PRICEVALIDATOR_H
 #define PRICEVALIDATOR_H
 
+#include "StockAnalysis.h"
+
 #include <QString>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+
+struct PriceValidationOptions {
+    double priceTolerance = 0.005;   // Trade prices further than this from the latest close, relative, are reset to it
+    qint64 barSeconds = 86400;       // Span of a cached bar, only trades stored before the newest bar ended predate its close
+    double suspiciousScore = 0.80;   // Stored total scores at or above this are recomputed from the cached bars
+    double scoreTolerance = 0.05;    // A recomputed total further than this from the stored one replaces it
+    int windowBars = 28;             // Newest closes a score is recomputed from, about a scan's 40 days, at least ScoreWeights::historyBars()
+    double scoreCeiling = 1.1;       // Symbols scoring at or above this afterwards are excluded, as in a scan
+    ScoreWeights weights;            // Same weights the scores were written with
+};
 
+struct PriceValidationStats {
+    int PricesCorrected = 0;
+    int ScoresChecked = 0;
+    int ScoresUpdated = 0;
+    int SymbolsExcluded = 0;         // Too little history left to recompute the score
+    double ElapsedMs = 0.0;
+};
+
+// Reconciles stale cached trade prices with the latest cached close and recomputes suspiciously high scores. A trade is
+// stale when its stock row was last updated before the newest bar ended, a trade fetched later is left as it is. Prices are
+// corrected by a single UPDATE, scores come from one windowed query over the suspicious symbols and are written back
+// with batched statements, all in one transaction. Meant to run after new bars have been written to the cache.
 class PriceValidator {
 public:
     // Constructor
     explicit PriceValidator(QSqlDatabase& database);
 
-    void validateAndCorrectPrices() const;
-    void revalidateSuspiciousScores() const;
+    // Returns false and leaves the cache untouched if any step fails, lastError() holds the reason
+    bool run(const PriceValidationOptions& options = PriceValidationOptions());
+
+    const QString& lastError() const;
+    const PriceValidationStats& stats() const;
 
 private:
     QSqlDatabase& db;
 
-    double getLatestClosingPrice(const QString& symbol) const;
+    QString errorMessage;
+    PriceValidationStats validationStats;
 
-    void updateTradePrice(const QString& symbol, double correctedPrice) const;
+    bool correctPrices(const PriceValidationOptions& options);
+    bool revalidateScores(const PriceValidationOptions& options);
+    bool fail(const QSqlQuery& query);
 };
 
 #endif // PRICEVALIDATOR_H
@@ -1,76 +1,126 @@
 #include "StockAnalysis.h"
+#include "IndicatorPipeline.h"
 
-#include <numeric>
+#include <algorithm>
 #include <cmath>
-#include <stdexcept>
-#include <QMessageBox>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QVariant>
-
-// Constructor implementation
-StockAnalysis::StockAnalysis(QSqlDatabase& database)
-    : db(database) {}
-
-std::pair<double, double> StockAnalysis::calculateBollingerBands(const std::vector<double>& prices, int period, double numStdDev) {
-    // If not enough data, mark symbol as excluded to prevent it from being rendered.
-    if (prices.size() < static_cast<size_t>((period - 10)))
-        return { static_cast<double>(-1), static_cast<double>(-1)}; // Return invalid to the calling function
-
-    // Compute moving average over the last period points
-    double sum = std::accumulate(prices.end() - period, prices.end(), 0.0);
-    double movingAverage = sum / period;
-
-    // Compute (population) std-dev
-    double sumSquares = 0.0;
-
-    for (auto it = prices.end() - period; it != prices.end(); ++it) {
-        double diff = *it - movingAverage;
-        sumSquares += diff * diff;
+#include <cstdlib>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace {
+    template <typename T, typename... Stages>
+    constexpr bool isSelected = (std::is_same_v<T, Stages> || ...);
+
+    template <typename Stage>
+    double weightOf(const ScoreWeights& weights) {
+        if constexpr (std::is_same_v<Stage, Ema<20>>)
+            return weights.ema;
+        else if constexpr (std::is_same_v<Stage, Macd<12, 26, 9>>)
+            return weights.macd;
+        else if constexpr (std::is_same_v<Stage, Atr<14>>)
+            return weights.atr;
+        else if constexpr (std::is_same_v<Stage, Vwap>)
+            return weights.vwap;
+        else
+            return weights.volume;
     }
 
-    double stdDev = std::sqrt(sumSquares / period);
-    double upperBand = movingAverage + numStdDev * stdDev;
-    double lowerBand = movingAverage - numStdDev * stdDev;
+    std::string trimmed(const std::string& text) {
+        std::size_t begin = text.find_first_not_of(" \t");
+        std::size_t end = text.find_last_not_of(" \t");
+
+        return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+    }
 
-    return { upperBand, lowerBand };
+    // The indicators after bb need more than closes, see ScoreWeights::usesBars()
+    const std::pair<const char*, double ScoreWeights::*> weightNames[] = {
+        { "ma", &ScoreWeights::ma }, { "rsi", &ScoreWeights::rsi }, { "bb", &ScoreWeights::bb }, { "ema", &ScoreWeights::ema },
+        { "macd", &ScoreWeights::macd }, { "atr", &ScoreWeights::atr }, { "vwap", &ScoreWeights::vwap }, { "volume", &ScoreWeights::volume }
+    };
 }
 
-double StockAnalysis::calculateMovingAverage(const std::vector<double>& prices, int period) {
-    // If not enough data, mark symbol as excluded to prevent it from being rendered.
-    if (prices.size() < static_cast<size_t>((period - 10)))
-        return static_cast<double>(-1); // Return invalid to the calling function
+bool ScoreWeights::usesBars() const {
+    return ema != 0 || macd != 0 || atr != 0 || vwap != 0 || volume != 0;
+}
 
-    double sum = std::accumulate(prices.end() - period, prices.end(), 0.0);
+int ScoreWeights::historyBars() const {
+    // Only the weighted stages run, so only they hold the window back
+    return std::apply([&](auto... stage) {
+        return std::max({ WindowStatistics::historyBars, (weightOf<decltype(stage)>(*this) != 0 ? decltype(stage)::historyBars : 0)... });
+    }, OptionalStages());
+}
 
-    return sum / period;
+int ScoreWeights::historyDays() const {
+    return (historyBars() * 7 + 4) / 5 + 7;
 }
 
-double StockAnalysis::calculateRSI(const std::vector<double>& prices, int period) {
-    // If not enough data, mark symbol as excluded to prevent it from being rendered.
-    if (prices.size() < static_cast<size_t>((period - 10)))
-        return static_cast<double>(-1); // Return invalid to the calling function
+bool ScoreWeights::parse(const std::string& text, ScoreWeights& weights, std::string& errorMessage) {
+    ScoreWeights parsed;
+    double total = 0.0;
 
-    double gain = 0.0, loss = 0.0;
+    for (const auto& [name, member] : weightNames)
+        parsed.*member = 0.0;
 
-    for (size_t i = prices.size() - period; i < prices.size() - 1; ++i) {
-        double change = prices[i + 1] - prices[i];
+    std::size_t position = 0;
 
-        if (change > 0)
-            gain += change;
-        else
-            loss -= change;
+    while (position <= text.size()) {
+        std::size_t comma = std::min(text.find(',', position), text.size());
+        std::string entry = trimmed(text.substr(position, comma - position));
+        position = comma + 1;
+
+        if (entry.empty())
+            continue;
+
+        std::size_t equals = entry.find('=');
+        std::string name = trimmed(entry.substr(0, equals));
+        std::string value = equals == std::string::npos ? std::string() : trimmed(entry.substr(equals + 1));
+        auto known = std::find_if(std::begin(weightNames), std::end(weightNames), [&](const auto& weight) { return name == weight.first; });
+
+        if (known == std::end(weightNames)) {
+            errorMessage = "Unknown indicator in weights: " + name;
+
+            return false;
+        }
+
+        char* end = nullptr;
+        double weight = std::strtod(value.c_str(), &end);
+
+        if (value.empty() || *end != '\0' || !std::isfinite(weight) || weight < 0) {
+            errorMessage = "Weight of " + name + " must be a non-negative number";
+
+            return false;
+        }
+
+        parsed.*(known->second) = weight;
     }
 
-    double avgGain = gain / period;
-    double avgLoss = loss / period;
+    for (const auto& [name, member] : weightNames)
+        total += parsed.*member;
+
+    if (total <= 0) {
+        errorMessage = "At least one indicator needs a positive weight";
+
+        return false;
+    }
 
-    if (avgLoss == 0)
-        return 100.0;
+    for (const auto& [name, member] : weightNames)
+        parsed.*member /= total;
 
-    double rs = avgGain / avgLoss;
+    weights = parsed;
 
-    return 100.0 - (100.0 / (1.0 + rs));
+    return true;
+}
+
+bool ScoreWeights::fromEnvironment(ScoreWeights& weights, std::string& errorMessage) {
+    const char* configured = std::getenv("STOCKHOUND_WEIGHTS");
+
+    if (configured == nullptr || parse(configured, weights, errorMessage))
+        return true;
+
+    errorMessage = "Ignoring STOCKHOUND_WEIGHTS: " + errorMessage;
+
+    return false;
 }
 
 double StockAnalysis::calculateMAScore(double price, double movingAverage) {
@@ -85,38 +135,97 @@ double StockAnalysis::calculateBBScore(double price, double lowerBand, double up
     return 1.0 - (price - lowerBand) / (upperBand - lowerBand);
 }
 
-std::vector<double> StockAnalysis::calculateTotalScores(std::string symbol, double price, const std::vector<double>& prices, int period) {
+double StockAnalysis::calculateMACDScore(double price, double histogram) {
+    return 0.5 + 0.5 * std::tanh(histogram / (0.01 * price)); // A histogram of 1% of the price scores about 0.88
+}
+
+double StockAnalysis::calculateATRScore(double price, double averageTrueRange) {
+    return 1.0 - std::min(averageTrueRange / price / 0.10, 1.0); // Daily ranges of 10% or more score 0
+}
+
+double StockAnalysis::calculateVolumeScore(double relativeVolume) {
+    return std::min(relativeVolume, 2.0) / 2.0; // Usual volume scores 0.5, double or more scores 1
+}
+
+ScoreCard StockAnalysis::calculateTotalScores(double price, std::span<const double> prices, int period) {
     // Calculate indicators
-    double movingAverage = calculateMovingAverage(prices, period);
-    double rsi = calculateRSI(prices, period);
-    auto [upperBand, lowerBand] = calculateBollingerBands(prices, period);
+    return calculateTotalScores(price, IndicatorKernels::compute(prices, period));
+}
+
+ScoreCard StockAnalysis::calculateTotalScores(double price, const Indicators& indicators, const ScoreWeights& weights) {
+    double movingAverage = indicators.MovingAverage;
+    double rsi = indicators.RSI;
+    double upperBand = indicators.UpperBand;
+    double lowerBand = indicators.LowerBand;
 
-    // If any scores are invalid, mark as excluded
+    // If any indicator is invalid the symbol lacks history, the caller decides what to do with it
     if (movingAverage == static_cast<double>(-1) ||
         rsi == static_cast<double>(-1) ||
-        (upperBand == static_cast<double>(-1) && lowerBand == static_cast<double>(-1))) {
-        QSqlQuery markExcludedQuery(db);
+        (upperBand == static_cast<double>(-1) && lowerBand == static_cast<double>(-1)))
+        return {}; // Invalid score card
 
-        markExcludedQuery.prepare("UPDATE stocks SET excluded = 1 WHERE symbol = :symbol");
-        markExcludedQuery.bindValue(":symbol", QVariant(QString::fromStdString(symbol)));
-
-        if (!markExcludedQuery.exec())
-            QMessageBox::critical(nullptr, "Database Error", "Query execution failed:" + markExcludedQuery.lastError().text());
-
-        return {}; // Return empty vector
-    }
+    ScoreCard scores;
 
     // Calculate individual scores
-    double maScore = calculateMAScore(price, movingAverage) * 0.4;
-    double rsiScore = calculateRSIScore(rsi) * 0.3;
-    double bbScore = calculateBBScore(price, lowerBand, upperBand) * 0.3;
+    scores.MA_Score = calculateMAScore(price, movingAverage) * weights.ma;
+    scores.RSI_Score = calculateRSIScore(rsi) * weights.rsi;
+    scores.BB_Score = calculateBBScore(price, lowerBand, upperBand) * weights.bb;
 
     // Calculate total weighted score
-    double totalScore = maScore + rsiScore + bbScore;
+    scores.Total_Score = scores.MA_Score + scores.RSI_Score + scores.BB_Score;
+    scores.Valid = true;
+
+    return scores;
+}
+
+template <typename... Stages>
+ScoreCard StockAnalysis::scorePipeline(double price, const BarSeries& bars, const ScoreWeights& weights) {
+    IndicatorPipeline<WindowStatistics, Stages...> pipeline;
+
+    pipeline.run(bars);
+
+    ScoreCard scores = calculateTotalScores(price, pipeline.template get<WindowStatistics>().indicators(), weights);
 
-    // Return all values
-    std::vector<double> scores = { maScore, rsiScore, bbScore, totalScore };
+    if (!scores.Valid)
+        return scores;
+
+    // Every stage here has a weight, one that lacks history invalidates the card
+    if (!(pipeline.template get<Stages>().ready() && ...))
+        return {};
+
+    if constexpr (isSelected<Ema<20>, Stages...>)
+        scores.Total_Score += calculateMAScore(price, pipeline.template get<Ema<20>>().value()) * weights.ema;
+
+    if constexpr (isSelected<Macd<12, 26, 9>, Stages...>)
+        scores.Total_Score += calculateMACDScore(price, pipeline.template get<Macd<12, 26, 9>>().histogram()) * weights.macd;
+
+    if constexpr (isSelected<Atr<14>, Stages...>)
+        scores.Total_Score += calculateATRScore(price, pipeline.template get<Atr<14>>().value()) * weights.atr;
+
+    if constexpr (isSelected<Vwap, Stages...>)
+        scores.Total_Score += calculateMAScore(price, pipeline.template get<Vwap>().value()) * weights.vwap;
+
+    if constexpr (isSelected<RelativeVolume<5>, Stages...>)
+        scores.Total_Score += calculateVolumeScore(pipeline.template get<RelativeVolume<5>>().value()) * weights.volume;
 
     return scores;
 }
 
+template <std::size_t Stage, typename... Selected>
+ScoreCard StockAnalysis::selectStages(double price, const BarSeries& bars, const ScoreWeights& weights) {
+    if constexpr (Stage == std::tuple_size_v<OptionalStages>) {
+        return scorePipeline<Selected...>(price, bars, weights);
+    } else {
+        using Next = std::tuple_element_t<Stage, OptionalStages>;
+
+        if (weightOf<Next>(weights) != 0)
+            return selectStages<Stage + 1, Selected..., Next>(price, bars, weights);
+
+        return selectStages<Stage + 1, Selected...>(price, bars, weights);
+    }
+}
+
+ScoreCard StockAnalysis::calculateTotalScores(double price, const BarSeries& bars, const ScoreWeights& weights) {
+    // One pipeline type per combination of weighted stages, so the pass only carries the indicators that count
+    return selectStages<0>(price, bars, weights);
+}
@@ -1,26 +1,81 @@
 #ifndef STOCK_ANALYSIS_H
 #define STOCK_ANALYSIS_H
 
-#include <vector>
-#include <QString>
-#include <QSqlDatabase>
+#include <cstddef>
+#include <span>
+#include <string>
+#include "IndicatorKernels.h"
 
+struct BarSeries;
+
+// Weighted scores of one symbol. Valid is false when there was not enough history to score it, callers are expected
+// to exclude such symbols. Total_Score also holds the share of any indicator beyond MA, RSI and BB.
+struct ScoreCard {
+    double MA_Score = 0.0;
+    double RSI_Score = 0.0;
+    double BB_Score = 0.0;
+    double Total_Score = 0.0;
+    bool Valid = false;
+};
+
+// Weight of each indicator in the total score. The defaults are the original MA/RSI/BB model, the indicators after bb
+// stay out of the score, and out of the data pass, until they are given a weight.
+struct ScoreWeights {
+    double ma = 0.4;
+    double rsi = 0.3;
+    double bb = 0.3;
+    double ema = 0.0;       // Price against the 20-bar EMA, scored like the moving average
+    double macd = 0.0;      // MACD(12, 26, 9) histogram, above 0.5 while momentum turns up. Needs 34 bars
+    double atr = 0.0;       // 14-bar ATR relative to the price, calmer symbols score higher
+    double vwap = 0.0;      // Price against the window's VWAP, scored like the moving average
+    double volume = 0.0;    // Volume of the last 5 bars against the window average
+
+    // True if an indicator that needs highs, lows or volumes has a weight, the scan then scores from the full bars
+    bool usesBars() const;
+
+    // Daily bars a symbol needs before every weighted indicator is ready, at least the 10 of MA, RSI and BB
+    int historyBars() const;
+
+    // Calendar days of daily bars that hold historyBars() trading days, with a week to spare for holidays
+    int historyDays() const;
+
+    // Reads "ma=0.5,rsi=0.3,macd=0.2". Names left out get no weight, the rest are scaled to add up to 1 so totals stay
+    // comparable with the score ceiling. Returns false and leaves weights untouched on bad input.
+    static bool parse(const std::string& text, ScoreWeights& weights, std::string& errorMessage);
+
+    // Reads STOCKHOUND_WEIGHTS into weights if it is set. Returns false and leaves weights untouched if it is not valid,
+    // reporting that is up to the caller.
+    static bool fromEnvironment(ScoreWeights& weights, std::string& errorMessage);
+};
+
+// Pure scoring math with no database or UI access, safe to call from any thread
 class StockAnalysis {
 private:
-    QSqlDatabase& db;
-
-    static std::pair<double, double> calculateBollingerBands(const std::vector<double>& prices, int period = 20, double numStdDev = 2.0);
-    static double calculateMovingAverage(const std::vector<double>& prices, int period);
-    static double calculateRSI(const std::vector<double>& prices, int period = 14);
     static double calculateMAScore(double price, double movingAverage);
     static double calculateRSIScore(double rsi);
     static double calculateBBScore(double price, double lowerBand, double upperBand);
+    static double calculateMACDScore(double price, double histogram);
+    static double calculateATRScore(double price, double averageTrueRange);
+    static double calculateVolumeScore(double relativeVolume);
+
+    // One pass of the window statistics plus Stages, which are exactly the weighted stages of OptionalStages
+    template <typename... Stages>
+    static ScoreCard scorePipeline(double price, const BarSeries& bars, const ScoreWeights& weights);
+
+    // Adds the stages of OptionalStages from Stage on that have a weight, then runs that pipeline
+    template <std::size_t Stage, typename... Selected>
+    static ScoreCard selectStages(double price, const BarSeries& bars, const ScoreWeights& weights);
 
 public:
-    // Constructor
-    explicit StockAnalysis(QSqlDatabase& database);
+    // Indicators come from a single fused pass over the last period prices
+    static ScoreCard calculateTotalScores(double price, std::span<const double> prices, int period);
+
+    // Same scores from indicators already computed in a batch by IndicatorKernels, only the MA, RSI and BB weights apply
+    static ScoreCard calculateTotalScores(double price, const Indicators& indicators, const ScoreWeights& weights = ScoreWeights());
 
-    std::vector<double> calculateTotalScores(std::string symbol, double price, const std::vector<double>& prices, int period);
+    // Every weighted indicator from one pass over the whole series, the pipeline only holds the stages with a weight.
+    // Invalid if any of them lacks the history it needs.
+    static ScoreCard calculateTotalScores(double price, const BarSeries& bars, const ScoreWeights& weights);
 };
 
 #endif // STOCK_ANALYSIS_H
@@ -0,0 +1,195 @@
+#include "BarSync.h"
+
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+BarSync::BarSync(QSqlDatabase& database, BatchFetcher& batchFetcher) : db(database), fetcher(batchFetcher) {}
+
+const QString& BarSync::lastError() const {
+    return errorMessage;
+}
+
+const BarSyncStats& BarSync::stats() const {
+    return syncStats;
+}
+
+std::string BarSync::isoTimestamp(qint64 timestamp) {
+    return QDateTime::fromSecsSinceEpoch(timestamp, Qt::UTC).toString(Qt::ISODate).toStdString();
+}
+
+bool BarSync::loadNewestBars(std::unordered_map<std::string, StoredBar>& newest) {
+    QSqlQuery newestQuery(db);
+
+    // SQLite takes bare columns from the row that holds the MAX(), so close belongs to the newest bar
+    if (!newestQuery.exec("SELECT symbol, MAX(timestamp), close FROM historical_data GROUP BY symbol")) {
+        errorMessage = "Query execution failed:" + newestQuery.lastError().text();
+
+        return false;
+    }
+
+    while (newestQuery.next())
+        newest.emplace(newestQuery.value(0).toString().toStdString(), StoredBar{ newestQuery.value(1).toLongLong(), newestQuery.value(2).toDouble(), 0 });
+
+    QSqlQuery oldestQuery(db);
+
+    if (!oldestQuery.exec("SELECT symbol, MIN(timestamp) FROM historical_data GROUP BY symbol")) {
+        errorMessage = "Query execution failed:" + oldestQuery.lastError().text();
+
+        return false;
+    }
+
+    while (oldestQuery.next()) {
+        auto it = newest.find(oldestQuery.value(0).toString().toStdString());
+
+        if (it != newest.end())
+            it->second.Oldest = oldestQuery.value(1).toLongLong();
+    }
+
+    return true;
+}
+
+bool BarSync::loadWindow(qint64 windowStart, qint64 windowEnd, std::unordered_map<std::string, SymbolBars>& bars) {
+    QSqlQuery windowQuery(db);
+
+    windowQuery.setForwardOnly(true);
+    windowQuery.prepare("SELECT symbol, timestamp, open, high, low, close, volume FROM historical_data "
+                        "WHERE timestamp >= :start AND timestamp <= :end ORDER BY symbol, timestamp");
+    windowQuery.bindValue(":start", windowStart);
+    windowQuery.bindValue(":end", windowEnd);
+
+    if (!windowQuery.exec()) {
+        errorMessage = "Query execution failed:" + windowQuery.lastError().text();
+
+        return false;
+    }
+
+    while (windowQuery.next()) {
+        auto it = bars.find(windowQuery.value(0).toString().toStdString());
+
+        // Only symbols taking part in this sync
+        if (it == bars.end())
+            continue;
+
+        it->second.Window.push_back(BarData{
+            windowQuery.value(1).toLongLong(),
+            windowQuery.value(2).toDouble(),
+            windowQuery.value(3).toDouble(),
+            windowQuery.value(4).toDouble(),
+            windowQuery.value(5).toDouble(),
+            windowQuery.value(6).toLongLong()
+        });
+    }
+
+    return true;
+}
+
+void BarSync::mergeFresh(SymbolBars& symbolBars) {
+    if (symbolBars.Replace) {
+        symbolBars.Window = symbolBars.Fresh;
+
+        return;
+    }
+
+    // Fresh bars win over stored ones with the same timestamp
+    std::map<qint64, BarData> merged;
+
+    for (const BarData& bar : symbolBars.Window)
+        merged.insert_or_assign(bar.Timestamp, bar);
+
+    for (const BarData& bar : symbolBars.Fresh)
+        merged.insert_or_assign(bar.Timestamp, bar);
+
+    symbolBars.Window.clear();
+    symbolBars.Window.reserve(merged.size());
+
+    for (const auto& [timestamp, bar] : merged)
+        symbolBars.Window.push_back(bar);
+}
+
+bool BarSync::sync(const std::vector<std::string>& symbols, qint64 windowStart, qint64 windowEnd, const std::string& timeframe,
+                   std::unordered_map<std::string, SymbolBars>& bars) {
+    std::unordered_map<std::string, StoredBar> newest;
+
+    syncStats = BarSyncStats();
+    bars.reserve(bars.size() + symbols.size());
+
+    if (!loadNewestBars(newest))
+        return false;
+
+    // Symbols whose newest bar is inside the window only need what came after it. They are grouped by that
+    // timestamp, which after a daily refresh is the same for nearly everyone, so deltas still batch well. History that
+    // starts well after the window, because the window was widened, is requested in full; recently listed symbols then
+    // come along too, as nothing tells them apart.
+    std::map<qint64, std::vector<std::string>> deltaGroups;
+    std::vector<std::string> fullSymbols;
+
+    for (const std::string& symbol : symbols) {
+        bars.try_emplace(symbol);
+
+        auto it = newest.find(symbol);
+
+        if (it == newest.end() || it->second.Timestamp < windowStart || it->second.Oldest > windowStart + startSlack)
+            fullSymbols.push_back(symbol);
+        else
+            deltaGroups[it->second.Timestamp].push_back(symbol);
+    }
+
+    std::string end = isoTimestamp(windowEnd);
+
+    for (const auto& [since, groupSymbols] : deltaGroups) {
+        std::unordered_map<std::string, std::vector<BarData>> fetched;
+
+        // Start at the newest stored bar itself, it is compared below to spot adjusted history
+        fetcher.fetchBars(groupSymbols, isoTimestamp(since), end, timeframe, fetched);
+
+        for (const std::string& symbol : groupSymbols) {
+            std::vector<BarData>& fresh = fetched[symbol];
+            const StoredBar& stored = newest.at(symbol);
+            auto overlap = std::find_if(fresh.begin(), fresh.end(), [&](const BarData& bar) { return bar.Timestamp == stored.Timestamp; });
+
+            // A missing overlap bar is treated like a gap, a different close means splits or dividends were applied upstream
+            bool adjusted = overlap != fresh.end() && std::abs(overlap->Close - stored.Close) > adjustmentTolerance * std::abs(stored.Close);
+
+            if (overlap == fresh.end() && !fresh.empty()) {
+                fullSymbols.push_back(symbol);
+                continue;
+            }
+
+            if (adjusted) {
+                bars[symbol].Replace = true;
+                fullSymbols.push_back(symbol);
+                ++syncStats.AdjustedSymbols;
+                continue;
+            }
+
+            bars[symbol].Fresh = std::move(fresh);
+            ++syncStats.DeltaSymbols;
+        }
+    }
+
+    // Whole window for new symbols, symbols with a gap and adjusted ones
+    if (!fullSymbols.empty()) {
+        std::unordered_map<std::string, std::vector<BarData>> fetched;
+
+        fetcher.fetchBars(fullSymbols, isoTimestamp(windowStart), end, timeframe, fetched);
+
+        for (const std::string& symbol : fullSymbols)
+            bars[symbol].Fresh = std::move(fetched[symbol]);
+
+        syncStats.FullSymbols = static_cast<int>(fullSymbols.size()) - syncStats.AdjustedSymbols;
+    }
+
+    if (!loadWindow(windowStart, windowEnd, bars))
+        return false;
+
+    for (auto& [symbol, symbolBars] : bars)
+        mergeFresh(symbolBars);
+
+    return true;
+}
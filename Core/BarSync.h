@@ -0,0 +1,61 @@
+#ifndef BAR_SYNC_H
+#define BAR_SYNC_H
+
+#include "BatchFetcher.h"
+#include "MarketData.h"
+
+#include <QSqlDatabase>
+#include <QString>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SymbolBars {
+    std::vector<BarData> Window;   // Every bar inside the scoring window, oldest first
+    std::vector<BarData> Fresh;    // Bars that came from the API and still have to be written
+    bool Replace = false;          // Stored history was adjusted upstream and has to be replaced
+};
+
+struct BarSyncStats {
+    int DeltaSymbols = 0;      // Only bars after the newest stored one were requested
+    int FullSymbols = 0;       // No usable history or too short of it, the whole window was requested
+    int AdjustedSymbols = 0;   // Stored bars no longer matched the API and were reloaded
+};
+
+// Requests only the daily bars each symbol is missing, falling back to the full window after a gap or a corporate action
+class BarSync {
+public:
+    // Relative close difference on the overlapping bar that counts as a split or dividend adjustment
+    static constexpr double adjustmentTolerance = 0.001;
+
+    // Stored history may start this long after the window does, for weekends and holidays, before it is reloaded
+    static constexpr qint64 startSlack = 5 * 86400;
+
+    BarSync(QSqlDatabase& database, BatchFetcher& batchFetcher);
+
+    bool sync(const std::vector<std::string>& symbols, qint64 windowStart, qint64 windowEnd, const std::string& timeframe,
+              std::unordered_map<std::string, SymbolBars>& bars);
+
+    const QString& lastError() const;
+    const BarSyncStats& stats() const;
+
+private:
+    struct StoredBar {
+        qint64 Timestamp;
+        double Close;
+        qint64 Oldest;    // Timestamp of the oldest stored bar
+    };
+
+    QSqlDatabase& db;
+    BatchFetcher& fetcher;
+
+    QString errorMessage;
+    BarSyncStats syncStats;
+
+    bool loadNewestBars(std::unordered_map<std::string, StoredBar>& newest);
+    bool loadWindow(qint64 windowStart, qint64 windowEnd, std::unordered_map<std::string, SymbolBars>& bars);
+    static std::string isoTimestamp(qint64 timestamp);
+    static void mergeFresh(SymbolBars& symbolBars);
+};
+
+#endif // BAR_SYNC_H
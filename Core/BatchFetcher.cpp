@@ -0,0 +1,176 @@
+#include "BatchFetcher.h"
+#include "ThirdParty/alpaca-trade-api-cpp/alpaca/client.h"
+#include "ThirdParty/alpaca-trade-api-cpp/alpaca/config.h"
+
+#include <QDateTime>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace {
+    FetchOutcome outcomeFromStatus(const alpaca::Status& status) {
+        if (status.ok())
+            return FetchOutcome{ true, 200, false, std::string() };
+
+        std::string message = status.getMessage();
+        int httpStatus = FetchScheduler::httpStatusFromMessage(message);
+
+        // The client reports a call without any HTTP response as an empty response
+        bool transport = httpStatus == 0 && message.find("empty response") != std::string::npos;
+
+        return FetchOutcome{ false, httpStatus, transport, message };
+    }
+}
+
+BatchFetcher::BatchFetcher(alpaca::Environment& env, const std::string& agent, const FetchSchedulerOptions& options, const std::atomic<bool>* cancelRequested)
+    : userAgent(agent) {
+    scheduler = std::make_unique<FetchScheduler>(options, cancelRequested);
+
+    // Give every worker its own client so no connection state is shared between threads
+    for (std::size_t i = 0; i < scheduler->workerCount(); ++i)
+        clients.push_back(std::make_unique<alpaca::Client>(env));
+}
+
+// Stops the scheduler before the clients its workers use go away
+BatchFetcher::~BatchFetcher() {
+    scheduler.reset();
+}
+
+const std::unordered_set<std::string>& BatchFetcher::failedSymbols() const {
+    return failed;
+}
+
+FetchStats BatchFetcher::stats() {
+    return scheduler->stats();
+}
+
+void BatchFetcher::setMetrics(ScanMetrics* scanMetrics) {
+    metrics = scanMetrics;
+}
+
+void BatchFetcher::recordRequest(ApiEndpoint endpoint, std::chrono::steady_clock::time_point started, const FetchOutcome& outcome) {
+    if (metrics)
+        metrics->recordRequest(endpoint, std::chrono::steady_clock::now() - started, outcome.Ok, outcome.HttpStatus);
+}
+
+std::vector<BatchFetcher::Chunk> BatchFetcher::makeChunks(const std::vector<std::string>& symbols) {
+    std::vector<Chunk> chunks;
+
+    for (std::size_t first = 0; first < symbols.size(); first += symbolsPerRequest) {
+        std::size_t last = std::min(first + symbolsPerRequest, symbols.size());
+
+        chunks.push_back(std::make_shared<const std::vector<std::string>>(symbols.begin() + first, symbols.begin() + last));
+    }
+
+    return chunks;
+}
+
+std::vector<std::string> BatchFetcher::takeFailureMessages() {
+    std::lock_guard<std::mutex> lock(resultsMutex);
+
+    return std::exchange(failureMessages, {});
+}
+
+void BatchFetcher::markFailed(const Chunk& chunk, const FetchOutcome& outcome) {
+    std::lock_guard<std::mutex> lock(resultsMutex);
+
+    // After a cancel every outstanding chunk fails, that is not worth a line each
+    if (!scheduler->isCancelled())
+        failureMessages.push_back("Giving up on " + std::to_string(chunk->size()) + " symbols (" + chunk->front() + ".." + chunk->back() + "): " + outcome.Message);
+
+    failed.insert(chunk->begin(), chunk->end());
+}
+
+void BatchFetcher::fetchLatestTrades(const std::vector<std::string>& symbols, std::unordered_map<std::string, TradeData>& trades) {
+    trades.reserve(trades.size() + symbols.size());
+
+    for (const Chunk& chunk : makeChunks(symbols)) {
+        scheduler->submit([this, chunk, &trades](std::size_t worker) {
+            auto started = metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+            auto response = clients[worker]->getLatestTrades(*chunk, userAgent);
+            FetchOutcome outcome = outcomeFromStatus(response.first);
+
+            recordRequest(ApiEndpoint::LatestTrades, started, outcome);
+
+            if (outcome.Ok) {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+
+                for (const auto& [symbol, lastTrade] : response.second)
+                    trades.insert_or_assign(symbol, TradeData{ static_cast<double>(lastTrade.price), static_cast<qint64>(lastTrade.size) });
+            }
+
+            return outcome;
+        }, [this, chunk](const FetchOutcome& outcome) {
+            markFailed(chunk, outcome);
+        });
+    }
+
+    scheduler->wait();
+}
+
+void BatchFetcher::fetchBars(const std::vector<std::string>& symbols, const std::string& start, const std::string& end, const std::string& timeframe,
+                             std::unordered_map<std::string, std::vector<BarData>>& bars) {
+    auto request = std::make_shared<BarsRequest>(BarsRequest{ end, timeframe, &bars });
+
+    bars.reserve(bars.size() + symbols.size());
+
+    for (const Chunk& chunk : makeChunks(symbols))
+        submitBarsPage(chunk, request, start);
+
+    // Follow-up pages are submitted by the page before them, wait() covers those too
+    scheduler->wait();
+}
+
+void BatchFetcher::submitBarsPage(const Chunk& chunk, const std::shared_ptr<BarsRequest>& request, const std::string& start) {
+    scheduler->submit([this, chunk, request, start](std::size_t worker) {
+        auto started = metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        // The client takes symbols, start, end, after, until, timeframe, limit and user agent, paging is done through start
+        auto response = clients[worker]->getBars(*chunk, start, request->end, "", "", request->timeframe, barsPerPage, userAgent);
+        FetchOutcome outcome = outcomeFromStatus(response.first);
+
+        recordRequest(ApiEndpoint::Bars, started, outcome);
+
+        // A 200 without bars is a valid empty page, those symbols are excluded once scored without history
+        if (!outcome.Ok)
+            return outcome;
+
+        // Symbols that filled the page may have more bars, grouped by where their page ended
+        std::map<qint64, std::vector<std::string>> truncated;
+
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+
+            for (const auto& [symbol, symbolBars] : response.second.bars) {
+                std::vector<BarData>& history = (*request->bars)[symbol];
+
+                history.reserve(history.size() + symbolBars.size());
+
+                for (const auto& bar : symbolBars) {
+                    history.push_back(BarData{
+                        static_cast<qint64>(bar.time),
+                        bar.open_price,
+                        bar.high_price,
+                        bar.low_price,
+                        bar.close_price,
+                        static_cast<qint64>(bar.volume)
+                    });
+                }
+
+                if (symbolBars.size() >= static_cast<std::size_t>(barsPerPage))
+                    truncated[static_cast<qint64>(symbolBars.back().time)].push_back(symbol);
+            }
+        }
+
+        // The next page starts one second after the last bar read, so no bar is returned twice
+        for (auto& [last, symbols] : truncated) {
+            std::string next = QDateTime::fromSecsSinceEpoch(last + 1, Qt::UTC).toString(Qt::ISODate).toStdString();
+
+            submitBarsPage(std::make_shared<const std::vector<std::string>>(std::move(symbols)), request, next);
+        }
+
+        return outcome;
+    }, [this, chunk](const FetchOutcome& outcome) {
+        markFailed(chunk, outcome);
+    });
+}
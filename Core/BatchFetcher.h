@@ -0,0 +1,78 @@
+#ifndef BATCH_FETCHER_H
+#define BATCH_FETCHER_H
+
+#include "FetchScheduler.h"
+#include "MarketData.h"
+#include "ScanMetrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace alpaca {
+    class Client;
+    class Environment;
+}
+
+// Fetches trades and bars for many symbols per request instead of one round trip per symbol.
+// Requests go through a FetchScheduler, so several are in flight at once within the account rate limit.
+class BatchFetcher {
+public:
+    // Symbols per request, keeps the query string well below common URL length limits
+    static constexpr std::size_t symbolsPerRequest = 200;
+
+    // Bars per symbol and request, the largest limit the bars endpoint accepts
+    static constexpr int barsPerPage = 1000;
+
+    BatchFetcher(alpaca::Environment& env, const std::string& agent, const FetchSchedulerOptions& options, const std::atomic<bool>* cancelRequested = nullptr);
+    ~BatchFetcher();
+
+    // Chunks that still fail after retries are skipped, their symbols end up in failedSymbols()
+    void fetchLatestTrades(const std::vector<std::string>& symbols, std::unordered_map<std::string, TradeData>& trades);
+
+    // Symbols that fill a page are requested again from after their last bar until every bar in the range has been read
+    void fetchBars(const std::vector<std::string>& symbols, const std::string& start, const std::string& end, const std::string& timeframe,
+                   std::unordered_map<std::string, std::vector<BarData>>& bars);
+
+    const std::unordered_set<std::string>& failedSymbols() const;
+
+    // One line per chunk given up on since the last call, chunks that only failed because of a cancel are left out.
+    // Nothing is printed here, the caller decides where these go.
+    std::vector<std::string> takeFailureMessages();
+    FetchStats stats();
+
+    // Every request attempt is recorded here per endpoint, null turns recording off
+    void setMetrics(ScanMetrics* scanMetrics);
+
+private:
+    using Chunk = std::shared_ptr<const std::vector<std::string>>;
+
+    struct BarsRequest {
+        std::string end;
+        std::string timeframe;
+        std::unordered_map<std::string, std::vector<BarData>>* bars;
+    };
+
+    std::string userAgent;
+    std::vector<std::unique_ptr<alpaca::Client>> clients;  // One per scheduler worker
+    std::unique_ptr<FetchScheduler> scheduler;
+
+    std::mutex resultsMutex;
+    std::unordered_set<std::string> failed;
+    std::vector<std::string> failureMessages;
+
+    ScanMetrics* metrics = nullptr;
+
+    static std::vector<Chunk> makeChunks(const std::vector<std::string>& symbols);
+    void markFailed(const Chunk& chunk, const FetchOutcome& outcome);
+    void recordRequest(ApiEndpoint endpoint, std::chrono::steady_clock::time_point started, const FetchOutcome& outcome);
+    void submitBarsPage(const Chunk& chunk, const std::shared_ptr<BarsRequest>& request, const std::string& start);
+};
+
+#endif // BATCH_FETCHER_H
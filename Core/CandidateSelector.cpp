@@ -0,0 +1,194 @@
+#include "CandidateSelector.h"
+#include "ScanEngine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace {
+    // Whole non-negative numbers only, "10k" or "-1" are rejected rather than half read
+    bool parseCount(const char* text, std::size_t& count) {
+        char* end = nullptr;
+
+        if (text == nullptr || *text == '\0' || *text == '-')
+            return false;
+
+        unsigned long long value = std::strtoull(text, &end, 10);
+
+        if (*end != '\0')
+            return false;
+
+        count = static_cast<std::size_t>(value);
+
+        return true;
+    }
+
+    std::string trimmed(const std::string& text) {
+        std::size_t first = text.find_first_not_of(" \t\r");
+
+        if (first == std::string::npos)
+            return std::string();
+
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    }
+}
+
+bool CandidateLimits::active() const {
+    return topK != 0 || perSector != 0;
+}
+
+bool CandidateLimits::loadSectors(const std::string& path, std::unordered_map<std::string, std::string>& sectors, std::string& errorMessage) {
+    std::ifstream file(path);
+
+    if (!file) {
+        errorMessage = "Failed to open sector file: " + path;
+
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+
+        if (trimmed(line).empty())
+            continue;
+
+        std::size_t comma = line.find(',');
+
+        if (comma == std::string::npos) {
+            errorMessage = path + ":" + std::to_string(lineNumber) + ": expected symbol,sector";
+
+            return false;
+        }
+
+        std::string symbol = trimmed(line.substr(0, comma));
+        std::string sector = trimmed(line.substr(comma + 1));
+
+        if (lineNumber == 1 && (symbol == "symbol" || symbol == "Symbol"))
+            continue;
+
+        if (!symbol.empty() && !sector.empty())
+            sectors.insert_or_assign(symbol, sector);
+    }
+
+    return true;
+}
+
+bool CandidateLimits::fromEnvironment(CandidateLimits& limits, std::string& errorMessage) {
+    const char* topK = std::getenv("STOCKHOUND_TOP_K");
+    const char* perSector = std::getenv("STOCKHOUND_SECTOR_CAP");
+    const char* sectorPath = std::getenv("STOCKHOUND_SECTORS");
+    std::vector<std::string> skipped;
+
+    if (topK != nullptr && !parseCount(topK, limits.topK))
+        skipped.push_back("Ignoring STOCKHOUND_TOP_K: not a count: " + std::string(topK));
+
+    if (perSector != nullptr && !parseCount(perSector, limits.perSector))
+        skipped.push_back("Ignoring STOCKHOUND_SECTOR_CAP: not a count: " + std::string(perSector));
+
+    // Loaded aside so a file that fails halfway leaves no partial map behind
+    std::unordered_map<std::string, std::string> sectors;
+    std::string sectorsError;
+
+    if (sectorPath != nullptr && *sectorPath != '\0') {
+        if (loadSectors(sectorPath, sectors, sectorsError))
+            limits.sectors = std::move(sectors);
+        else
+            skipped.push_back("Ignoring STOCKHOUND_SECTORS: " + sectorsError);
+    }
+
+    if (skipped.empty())
+        return true;
+
+    errorMessage.clear();
+
+    for (const std::string& line : skipped)
+        errorMessage += (errorMessage.empty() ? "" : "\n") + line;
+
+    return false;
+}
+
+CandidateSelector::CandidateSelector(const CandidateLimits& candidateLimits)
+    : limits(candidateLimits) {
+    uncapped.capacity = limits.topK;
+}
+
+bool CandidateSelector::better(const StockInformation& a, const StockInformation& b) {
+    if (a.Total_Score != b.Total_Score)
+        return a.Total_Score > b.Total_Score;
+
+    return a.Symbol < b.Symbol;
+}
+
+bool CandidateSelector::offer(const StockInformation& info) {
+    if (limits.perSector == 0)
+        return push(uncapped, info);
+
+    auto sector = limits.sectors.find(info.Symbol);
+
+    if (sector == limits.sectors.end())
+        return push(uncapped, info);
+
+    auto [heap, inserted] = sectorHeaps.try_emplace(sector->second);
+
+    // A sector can never contribute more than topK either
+    if (inserted)
+        heap->second.capacity = limits.topK == 0 ? limits.perSector : std::min(limits.perSector, limits.topK);
+
+    return push(heap->second, info);
+}
+
+bool CandidateSelector::push(Heap& heap, const StockInformation& info) {
+    // Ordered by better, so the front of the heap is the worst candidate held
+    if (heap.capacity != 0 && heap.items.size() >= heap.capacity) {
+        if (!better(info, heap.items.front()))
+            return false;
+
+        std::pop_heap(heap.items.begin(), heap.items.end(), better);
+        heap.items.back() = info;
+        std::push_heap(heap.items.begin(), heap.items.end(), better);
+
+        return true;
+    }
+
+    heap.items.push_back(info);
+    std::push_heap(heap.items.begin(), heap.items.end(), better);
+
+    return true;
+}
+
+std::size_t CandidateSelector::size() const {
+    std::size_t held = uncapped.items.size();
+
+    for (const auto& [sector, heap] : sectorHeaps)
+        held += heap.items.size();
+
+    return held;
+}
+
+void CandidateSelector::take(std::vector<StockInformation>& selection) {
+    selection.clear();
+    selection.reserve(size());
+
+    auto drain = [&](Heap& heap) {
+        std::move(heap.items.begin(), heap.items.end(), std::back_inserter(selection));
+        heap.items.clear();
+    };
+
+    drain(uncapped);
+
+    for (auto& [sector, heap] : sectorHeaps)
+        drain(heap);
+
+    sectorHeaps.clear();
+
+    // The heaps together can hold more than topK, the best of them are the selection
+    std::size_t count = limits.topK == 0 ? selection.size() : std::min(limits.topK, selection.size());
+
+    std::partial_sort(selection.begin(), selection.begin() + static_cast<std::ptrdiff_t>(count), selection.end(), better);
+    selection.resize(count);
+}
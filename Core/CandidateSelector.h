@@ -0,0 +1,58 @@
+#ifndef CANDIDATE_SELECTOR_H
+#define CANDIDATE_SELECTOR_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct StockInformation;
+
+struct CandidateLimits {
+    std::size_t topK = 0;        // Best candidates kept per scan, 0 keeps every result
+    std::size_t perSector = 0;   // Most candidates kept from one sector, 0 for no cap
+    std::unordered_map<std::string, std::string> sectors;   // Symbol to sector, symbols without one are never capped
+
+    bool active() const;
+
+    // Reads symbol,sector lines, a header line starting with "symbol" is skipped
+    static bool loadSectors(const std::string& path, std::unordered_map<std::string, std::string>& sectors, std::string& errorMessage);
+
+    // Reads STOCKHOUND_TOP_K, STOCKHOUND_SECTOR_CAP and STOCKHOUND_SECTORS into limits. An invalid value is skipped and
+    // the others still apply, returns false with one line per skipped value in errorMessage for the caller to report.
+    static bool fromEnvironment(CandidateLimits& limits, std::string& errorMessage);
+};
+
+// Keeps the best candidates of a scan as they are offered, in min-heaps that never grow past the limits, so the rest of
+// the universe is dropped on arrival instead of being stored and sorted. Each sector has its own heap of at most
+// perSector candidates, the best topK over all heaps are the selection.
+class CandidateSelector {
+public:
+    explicit CandidateSelector(const CandidateLimits& candidateLimits);
+
+    // Higher total score first, ties broken by symbol so the selection does not depend on arrival order
+    static bool better(const StockInformation& a, const StockInformation& b);
+
+    // Returns false if the candidate cannot be part of the selection
+    bool offer(const StockInformation& info);
+
+    // Candidates currently held, at most the sector count times perSector plus topK
+    std::size_t size() const;
+
+    // Moves the selection out best first, the selector is empty afterwards
+    void take(std::vector<StockInformation>& selection);
+
+private:
+    struct Heap {
+        std::vector<StockInformation> items;   // Worst candidate at the front
+        std::size_t capacity = 0;              // 0 for no bound
+    };
+
+    CandidateLimits limits;
+    Heap uncapped;
+    std::unordered_map<std::string, Heap> sectorHeaps;
+
+    bool push(Heap& heap, const StockInformation& info);
+};
+
+#endif // CANDIDATE_SELECTOR_H
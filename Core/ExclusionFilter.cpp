@@ -0,0 +1,22 @@
+#include "ExclusionFilter.h"
+
+ExclusionFilter::ExclusionFilter(const ExclusionRules& rules)
+    : exclusionRules(rules) {}
+
+const ExclusionRules& ExclusionFilter::rules() const {
+    return exclusionRules;
+}
+
+ExclusionReason ExclusionFilter::checkHistory(std::size_t historyBars) const {
+    if (exclusionRules.minHistoryBars > 0 && historyBars < static_cast<std::size_t>(exclusionRules.minHistoryBars))
+        return ExclusionReason::InsufficientHistory;
+
+    return ExclusionReason::None;
+}
+
+ExclusionReason ExclusionFilter::checkScore(double totalScore) const {
+    if (totalScore >= exclusionRules.scoreCeiling)
+        return ExclusionReason::ScoreCeiling;
+
+    return ExclusionReason::None;
+}
@@ -0,0 +1,32 @@
+#ifndef EXCLUSION_FILTER_H
+#define EXCLUSION_FILTER_H
+
+#include <cstddef>
+
+struct ExclusionRules {
+    double scoreCeiling = 1.1;   // Total scores at or above this are treated as erroneous
+    int minHistoryBars = 10;     // Symbols with fewer daily bars in the window are not ranked
+};
+
+enum class ExclusionReason {
+    None,
+    InsufficientHistory,
+    ScoreCeiling
+};
+
+// Exclusion rules for one scan as plain in-memory predicates, deciding on a symbol never touches the database.
+// Stored flags come in with the cache query and are persisted by the scan's writer.
+class ExclusionFilter {
+public:
+    explicit ExclusionFilter(const ExclusionRules& exclusionRules);
+
+    ExclusionReason checkHistory(std::size_t historyBars) const;
+    ExclusionReason checkScore(double totalScore) const;
+
+    const ExclusionRules& rules() const;
+
+private:
+    ExclusionRules exclusionRules;
+};
+
+#endif // EXCLUSION_FILTER_H
@@ -0,0 +1,231 @@
+#include "FetchScheduler.h"
+
+#include <algorithm>
+#include <random>
+#include <regex>
+
+TokenBucket::TokenBucket(double tokensPerSecond, int bucketCapacity)
+    : rate(tokensPerSecond), capacity(std::max(1, bucketCapacity)), tokens(std::max(1, bucketCapacity)), lastRefill(std::chrono::steady_clock::now()) {}
+
+bool TokenBucket::acquire(const std::function<bool()>& isCancelled) {
+    // Unlimited
+    if (rate <= 0.0)
+        return !isCancelled();
+
+    while (!isCancelled()) {
+        std::chrono::duration<double> wait;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed = now - lastRefill;
+
+            tokens = std::min(capacity, tokens + elapsed.count() * rate);
+            lastRefill = now;
+
+            if (tokens >= 1.0) {
+                tokens -= 1.0;
+
+                return true;
+            }
+
+            wait = std::chrono::duration<double>((1.0 - tokens) / rate);
+        }
+
+        // Sleep in short slices so cancellation is noticed quickly
+        std::this_thread::sleep_for(std::min<std::chrono::duration<double>>(wait, std::chrono::milliseconds(100)));
+    }
+
+    return false;
+}
+
+FetchScheduler::FetchScheduler(const FetchSchedulerOptions& schedulerOptions, const std::atomic<bool>* cancelRequested)
+    : options(schedulerOptions),
+      externalCancel(cancelRequested),
+      bucket(schedulerOptions.requestsPerMinute / 60.0, schedulerOptions.burst) {
+    std::size_t count = static_cast<std::size_t>(std::max(1, options.maxInFlight));
+
+    workers.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+        workers.emplace_back(&FetchScheduler::workerLoop, this, i);
+}
+
+FetchScheduler::~FetchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    taskAvailable.notify_all();
+    backoffWake.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+std::size_t FetchScheduler::workerCount() const {
+    return workers.size();
+}
+
+std::size_t FetchScheduler::queueDepth() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return queue.size();
+}
+
+void FetchScheduler::submit(Attempt attempt, FailureHandler onFailure) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        queue.push_back(Task{ std::move(attempt), std::move(onFailure) });
+        ++pending;
+
+        std::lock_guard<std::mutex> statsLock(statsMutex);
+        counters.MaxQueueDepth = std::max(counters.MaxQueueDepth, queue.size());
+    }
+
+    taskAvailable.notify_one();
+}
+
+void FetchScheduler::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+FetchStats FetchScheduler::stats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    FetchStats result = counters;
+
+    if (!latencies.empty()) {
+        std::vector<double> sorted = latencies;
+        double total = 0.0;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        for (double latency : sorted)
+            total += latency;
+
+        result.AverageLatencyMs = total / sorted.size();
+        result.P95LatencyMs = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+        result.MaxLatencyMs = sorted.back();
+    }
+
+    return result;
+}
+
+int FetchScheduler::httpStatusFromMessage(const std::string& message) {
+    // API errors carry the status as "... HTTP 429 ..." or "... status 503 ..."
+    static const std::regex statusPattern(R"((?:HTTP|[Ss]tatus)[^0-9]{0,3}([1-5][0-9]{2}))");
+    std::smatch match;
+
+    if (std::regex_search(message, match, statusPattern))
+        return std::stoi(match[1].str());
+
+    return 0;
+}
+
+bool FetchScheduler::isRetryable(const FetchOutcome& outcome) {
+    if (outcome.Ok)
+        return false;
+
+    // Rate limited or server side trouble, or the request never got an answer at all. An error without a readable
+    // status is something else, e.g. a response that failed to parse, and would fail the same way again.
+    return outcome.HttpStatus == 429 || outcome.HttpStatus >= 500 || outcome.Transport;
+}
+
+bool FetchScheduler::isCancelled() const {
+    return stopping.load(std::memory_order_relaxed) || (externalCancel && externalCancel->load(std::memory_order_relaxed));
+}
+
+bool FetchScheduler::sleepFor(std::chrono::milliseconds duration) {
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // The destructor wakes the wait, the caller's flag is set without a notify and is checked in short slices
+    while (!isCancelled()) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (now >= deadline)
+            return true;
+
+        backoffWake.wait_for(lock, std::min<std::chrono::steady_clock::duration>(deadline - now, std::chrono::milliseconds(100)));
+    }
+
+    return false;
+}
+
+std::chrono::milliseconds FetchScheduler::backoffFor(int attempt) const {
+    // Exponential backoff with jitter keeps retrying workers from synchronising
+    thread_local std::mt19937 random(std::random_device{}());
+    long long ceiling = std::min<long long>(options.maxBackoff.count(), options.baseBackoff.count() << std::min(attempt, 20));
+    std::uniform_int_distribution<long long> jitter(ceiling / 2, std::max(ceiling / 2, ceiling));
+
+    return std::chrono::milliseconds(jitter(random));
+}
+
+void FetchScheduler::workerLoop(std::size_t worker) {
+    for (;;) {
+        Task task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            taskAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+
+            if (stopping && queue.empty())
+                return;
+
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        execute(task, worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (--pending == 0)
+                allDone.notify_all();
+        }
+    }
+}
+
+void FetchScheduler::execute(Task& task, std::size_t worker) {
+    FetchOutcome outcome{ false, 0, false, "Cancelled" };
+
+    for (int attempt = 0; attempt <= options.maxRetries; ++attempt) {
+        if (!bucket.acquire([this] { return isCancelled(); }))
+            break;
+
+        auto started = std::chrono::steady_clock::now();
+
+        outcome = task.attempt(worker);
+
+        std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - started;
+
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+
+            ++counters.Requests;
+            latencies.push_back(latency.count());
+
+            if (attempt > 0)
+                ++counters.Retries;
+        }
+
+        if (outcome.Ok || !isRetryable(outcome) || attempt == options.maxRetries || !sleepFor(backoffFor(attempt)))
+            break;
+    }
+
+    if (!outcome.Ok) {
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ++counters.Failures;
+        }
+
+        if (task.onFailure)
+            task.onFailure(outcome);
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef FETCH_SCHEDULER_H
+#define FETCH_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FetchSchedulerOptions {
+    int maxInFlight = 4;                                 // Requests allowed on the wire at once
+    double requestsPerMinute = 200.0;                    // Account rate limit, 0 disables the token bucket
+    int burst = 10;                                      // Requests that may be sent back to back after an idle period
+    int maxRetries = 4;                                  // Extra attempts for 429, 5xx and transport errors, anything else is final
+    std::chrono::milliseconds baseBackoff{250};
+    std::chrono::milliseconds maxBackoff{8000};
+};
+
+struct FetchOutcome {
+    bool Ok;
+    int HttpStatus;       // 0 when the request never got an HTTP response or the status could not be read
+    bool Transport;       // The request never got an HTTP response, e.g. a dropped connection
+    std::string Message;
+};
+
+struct FetchStats {
+    int Requests = 0;
+    int Retries = 0;
+    int Failures = 0;
+    std::size_t MaxQueueDepth = 0;
+    double AverageLatencyMs = 0.0;
+    double P95LatencyMs = 0.0;
+    double MaxLatencyMs = 0.0;
+};
+
+// Refills at a fixed rate and blocks callers until a token is available
+class TokenBucket {
+public:
+    TokenBucket(double tokensPerSecond, int capacity);
+
+    // Returns false if isCancelled() turns true while waiting
+    bool acquire(const std::function<bool()>& isCancelled);
+
+private:
+    std::mutex mutex;
+    double rate;
+    double capacity;
+    double tokens;
+    std::chrono::steady_clock::time_point lastRefill;
+};
+
+// Runs fetch tasks on a bounded pool, rate limits every attempt and retries transient failures with jittered backoff
+class FetchScheduler {
+public:
+    using Attempt = std::function<FetchOutcome(std::size_t worker)>;
+    using FailureHandler = std::function<void(const FetchOutcome& outcome)>;
+
+    explicit FetchScheduler(const FetchSchedulerOptions& schedulerOptions, const std::atomic<bool>* cancelRequested = nullptr);
+    ~FetchScheduler();
+
+    FetchScheduler(const FetchScheduler&) = delete;
+    FetchScheduler& operator=(const FetchScheduler&) = delete;
+
+    // Safe to call from inside a running attempt, e.g. to queue the next page of a paginated request
+    void submit(Attempt attempt, FailureHandler onFailure = {});
+
+    // Blocks until every submitted task, including follow-ups, succeeded or gave up
+    void wait();
+
+    std::size_t workerCount() const;
+
+    // True once the caller asked to cancel or the scheduler is shutting down
+    bool isCancelled() const;
+
+    std::size_t queueDepth();
+    FetchStats stats();
+
+    // Pulls the HTTP status out of an API error message, 0 if there is none
+    static int httpStatusFromMessage(const std::string& message);
+    static bool isRetryable(const FetchOutcome& outcome);
+
+private:
+    struct Task {
+        Attempt attempt;
+        FailureHandler onFailure;
+    };
+
+    FetchSchedulerOptions options;
+    const std::atomic<bool>* externalCancel;
+    std::atomic<bool> stopping{false};
+
+    TokenBucket bucket;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    std::condition_variable backoffWake;
+    std::deque<Task> queue;
+    std::size_t pending = 0;   // Queued plus running tasks
+
+    std::mutex statsMutex;
+    FetchStats counters;
+    std::vector<double> latencies;
+
+    void workerLoop(std::size_t worker);
+    void execute(Task& task, std::size_t worker);
+    std::chrono::milliseconds backoffFor(int attempt) const;
+
+    // Returns false if cancelled before the time is up
+    bool sleepFor(std::chrono::milliseconds duration);
+};
+
+#endif // FETCH_SCHEDULER_H
@@ -0,0 +1,205 @@
+#include "LiveWorker.h"
+#include "Analysis/StockAnalysis.h"
+#include "Database/CacheDatabase.h"
+#include "Database/CacheWriter.h"
+
+#include <QDateTime>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+    // Each worker thread needs its own connection, Qt connections can't be shared across threads
+    const QString workerConnectionName = QStringLiteral("live-worker");
+}
+
+LiveWorker::LiveWorker(const QString& databasePath, const std::vector<StockInformation>& candidates, const LiveOptions& options, QObject* parent)
+    : QObject(parent), dbPath(databasePath), liveOptions(options) {
+    qRegisterMetaType<StockInformation>();
+    qRegisterMetaType<QVector<StockInformation>>();
+
+    for (const StockInformation& candidate : candidates)
+        candidatesBySymbol.insert_or_assign(candidate.Symbol, candidate);
+}
+
+LiveWorker::~LiveWorker() {
+    closeDatabase();
+}
+
+void LiveWorker::run() {
+    QString errorMessage;
+
+    if (!CacheDatabase::open(db, dbPath, workerConnectionName, errorMessage)) {
+        emit failed(errorMessage);
+        closeDatabase();
+        emit finished();
+
+        return;
+    }
+
+    writer = std::make_unique<CacheWriter>(db);
+
+    if (!writer->prepare() || !IndicatorState::loadAll(db, indicatorStates, errorMessage)) {
+        emit failed(writer->lastError().isEmpty() ? errorMessage : writer->lastError());
+        closeDatabase();
+        emit finished();
+
+        return;
+    }
+
+    // The stored state only covers closes, the other indicators are computed from the same window the scan used
+    if (liveOptions.weights.usesBars()) {
+        int historyDays = std::max(liveOptions.historyDays, liveOptions.weights.historyDays());
+        qint64 since = QDateTime::currentDateTime().addDays(-1 - historyDays).toSecsSinceEpoch();
+
+        if (!barStore.load(db, errorMessage, since)) {
+            emit failed(errorMessage);
+            closeDatabase();
+            emit finished();
+
+            return;
+        }
+    }
+
+    QStringList symbols;
+
+    for (const auto& [symbol, candidate] : candidatesBySymbol)
+        symbols.append(QString::fromStdString(symbol));
+
+    // Created here so the socket and its timers live on this worker's thread
+    stream = new TradeStream(liveOptions.stream, this);
+
+    connect(stream, &TradeStream::ticksReady, this, &LiveWorker::onTicks);
+    connect(stream, &TradeStream::statusChanged, this, &LiveWorker::statusChanged);
+    connect(stream, &TradeStream::failed, this, &LiveWorker::failed);
+    connect(stream, &TradeStream::closed, this, &LiveWorker::stop);
+
+    stream->start(symbols);
+}
+
+void LiveWorker::stop() {
+    if (stream)
+        stream->stop();
+
+    closeDatabase();
+
+    emit finished();
+}
+
+void LiveWorker::closeDatabase() {
+    writer.reset();
+
+    if (!db.isValid())
+        return;
+
+    db.close();
+    db = QSqlDatabase();
+
+    // The connection may only be removed once no QSqlDatabase handle refers to it anymore
+    QSqlDatabase::removeDatabase(workerConnectionName);
+}
+
+bool LiveWorker::score(const std::string& symbol, double price, ScoreCard& scores) const {
+    if (liveOptions.weights.usesBars()) {
+        std::size_t index = barStore.indexOf(symbol);
+
+        if (index == PriceStore::npos)
+            return false;
+
+        scores = StockAnalysis::calculateTotalScores(price, barStore.series(index), liveOptions.weights);
+
+        return true;
+    }
+
+    // Symbols scanned before indicator state was kept have nothing to score from
+    auto state = indicatorStates.find(symbol);
+
+    if (state == indicatorStates.end())
+        return false;
+
+    scores = StockAnalysis::calculateTotalScores(price, state->second.indicators(), liveOptions.weights);
+
+    return true;
+}
+
+void LiveWorker::onTicks(const std::vector<TradeTick>& ticks) {
+    if (!writer)
+        return;
+
+    ExclusionFilter filter(liveOptions.exclusion);
+    QVector<StockInformation> updatedRows;
+    QStringList excludedSymbols;
+
+    updatedRows.reserve(static_cast<int>(ticks.size()));
+
+    // One transaction per flush, however many symbols moved
+    if (!writer->begin()) {
+        emit failed(writer->lastError());
+
+        return;
+    }
+
+    for (const TradeTick& tick : ticks) {
+        auto candidate = candidatesBySymbol.find(tick.Symbol);
+
+        if (candidate == candidatesBySymbol.end())
+            continue;
+
+        StockInformation info = candidate->second;
+        info.Price = tick.Price;
+
+        if (!writer->writeTrade(tick.Symbol, tick.Price, tick.Size)) {
+            emit failed(writer->lastError());
+            writer->rollback();
+
+            return;
+        }
+
+        ScoreCard scores;
+
+        if (score(tick.Symbol, tick.Price, scores)) {
+            ExclusionReason reason = scores.Valid ? filter.checkScore(scores.Total_Score) : ExclusionReason::InsufficientHistory;
+
+            // Same order as the scan, a valid score is stored even when it gets the symbol excluded
+            if (scores.Valid && !writer->writeScores(tick.Symbol, scores.MA_Score, scores.RSI_Score, scores.BB_Score, scores.Total_Score)) {
+                emit failed(writer->lastError());
+                writer->rollback();
+
+                return;
+            }
+
+            if (reason != ExclusionReason::None) {
+                if (!writer->markExcluded(tick.Symbol)) {
+                    emit failed(writer->lastError());
+                    writer->rollback();
+
+                    return;
+                }
+
+                candidatesBySymbol.erase(candidate);
+                excludedSymbols.append(QString::fromStdString(tick.Symbol));
+
+                continue;
+            }
+
+            info.MA_Score = scores.MA_Score;
+            info.RSI_Score = scores.RSI_Score;
+            info.BB_Score = scores.BB_Score;
+            info.Total_Score = scores.Total_Score;
+        }
+
+        candidate->second = info;
+        updatedRows.append(info);
+    }
+
+    if (!writer->commit()) {
+        emit failed(writer->lastError());
+
+        return;
+    }
+
+    if (!updatedRows.isEmpty())
+        emit rowsUpdated(updatedRows);
+
+    if (!excludedSymbols.isEmpty())
+        emit rowsExcluded(excludedSymbols);
+}
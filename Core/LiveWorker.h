@@ -0,0 +1,74 @@
+#ifndef LIVE_WORKER_H
+#define LIVE_WORKER_H
+
+#include "ExclusionFilter.h"
+#include "ScanWorker.h"
+#include "TradeStream.h"
+#include "Analysis/IndicatorState.h"
+#include "Analysis/PriceStore.h"
+#include "Analysis/StockAnalysis.h"
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CacheWriter;
+
+struct LiveOptions {
+    TradeStreamOptions stream = TradeStream::optionsFromEnvironment();
+    ExclusionRules exclusion;
+    int maxSymbols = 200;               // Shortlist size, the best scores are streamed
+    ScoreWeights weights;               // The scan's weights, so live scores stay comparable with its results
+    int historyDays = ScanOptions().historyDays;   // Window read back when the weights need full bars, widened like the scan if they need more
+};
+
+// Streams trades for a shortlist of scan results and rescores them at each new price. A trade is not a daily bar, so
+// the indicator windows stay as the last scan stored them and only the price they are scored against moves. Close-only
+// weights score from the stored indicator state in a handful of flops, weights that need full bars run the
+// weighted pipeline stages over the symbol's cached window. Either way a flush is one batched write. A symbol whose new score
+// is invalid or over the ceiling is marked excluded, as a scan would, and reported through rowsExcluded.
+class LiveWorker : public QObject {
+    Q_OBJECT
+
+public:
+    LiveWorker(const QString& databasePath, const std::vector<StockInformation>& candidates, const LiveOptions& options, QObject* parent = nullptr);
+    ~LiveWorker();
+
+public slots:
+    void run();
+    void stop();
+
+signals:
+    void rowsUpdated(const QVector<StockInformation>& rows);
+    void rowsExcluded(const QStringList& symbols);
+    void statusChanged(const QString& status);
+    void failed(const QString& message);
+    void finished();
+
+private slots:
+    void onTicks(const std::vector<TradeTick>& ticks);
+
+private:
+    QString dbPath;
+    LiveOptions liveOptions;
+    std::unordered_map<std::string, StockInformation> candidatesBySymbol;
+    std::unordered_map<std::string, IndicatorState> indicatorStates;
+    PriceStore barStore;   // Only loaded when the weights need full bars
+
+    QSqlDatabase db;
+    std::unique_ptr<CacheWriter> writer;
+    TradeStream* stream = nullptr;
+
+    void closeDatabase();
+
+    // False if nothing is stored to score the symbol from, its price is then refreshed on its own
+    bool score(const std::string& symbol, double price, ScoreCard& scores) const;
+};
+
+#endif // LIVE_WORKER_H
@@ -0,0 +1,20 @@
+#ifndef MARKET_DATA_H
+#define MARKET_DATA_H
+
+#include <QtGlobal>
+
+struct TradeData {
+    double Price;
+    qint64 Size;
+};
+
+struct BarData {
+    qint64 Timestamp;  // Unix timestamp of the bar
+    double Open;
+    double High;
+    double Low;
+    double Close;
+    qint64 Volume;
+};
+
+#endif // MARKET_DATA_H
@@ -0,0 +1,61 @@
+#include "ResultExport.h"
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+void ResultExport::rank(std::vector<StockInformation>& results) {
+    std::stable_sort(results.begin(), results.end(), [](const StockInformation& a, const StockInformation& b) {
+        return a.Total_Score > b.Total_Score;
+    });
+}
+
+void ResultExport::writeCsv(std::ostream& out, const std::vector<StockInformation>& results) {
+    out << "symbol,name,price,ma_score,rsi_score,bb_score,total_score\n";
+
+    for (const StockInformation& info : results) {
+        out << escapeCsv(info.Symbol) << ','
+            << escapeCsv(info.Name) << ','
+            << info.Price << ','
+            << info.MA_Score << ','
+            << info.RSI_Score << ','
+            << info.BB_Score << ','
+            << info.Total_Score << '\n';
+    }
+}
+
+void ResultExport::writeJson(std::ostream& out, const std::vector<StockInformation>& results) {
+    nlohmann::json rows = nlohmann::json::array();
+
+    for (const StockInformation& info : results) {
+        rows.push_back({
+            {"symbol", info.Symbol},
+            {"name", info.Name},
+            {"price", info.Price},
+            {"ma_score", info.MA_Score},
+            {"rsi_score", info.RSI_Score},
+            {"bb_score", info.BB_Score},
+            {"total_score", info.Total_Score}
+        });
+    }
+
+    out << rows.dump(2) << '\n';
+}
+
+std::string ResultExport::escapeCsv(const std::string& field) {
+    // Company names regularly contain commas, so quote any field that needs it
+    if (field.find_first_of(",\"\n") == std::string::npos)
+        return field;
+
+    std::string escaped = "\"";
+
+    for (char c : field) {
+        if (c == '"')
+            escaped += '"';
+
+        escaped += c;
+    }
+
+    escaped += '"';
+
+    return escaped;
+}
@@ -0,0 +1,21 @@
+#ifndef RESULT_EXPORT_H
+#define RESULT_EXPORT_H
+
+#include "ScanEngine.h"
+
+#include <ostream>
+#include <vector>
+
+class ResultExport {
+public:
+    // Sorts results by total score, best candidates first
+    static void rank(std::vector<StockInformation>& results);
+
+    static void writeCsv(std::ostream& out, const std::vector<StockInformation>& results);
+    static void writeJson(std::ostream& out, const std::vector<StockInformation>& results);
+
+private:
+    static std::string escapeCsv(const std::string& field);
+};
+
+#endif // RESULT_EXPORT_H
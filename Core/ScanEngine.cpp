@@ -0,0 +1,544 @@
+#include "ScanEngine.h"
+#include "BarSync.h"
+#include "BatchFetcher.h"
+#include "Analysis/IndicatorKernels.h"
+#include "Analysis/IndicatorState.h"
+#include "Analysis/ParallelScorer.h"
+#include "Analysis/PriceStore.h"
+#include "Analysis/PriceValidator.h"
+#include "Analysis/StockAnalysis.h"
+#include "Database/CacheWriter.h"
+#include "ThirdParty/alpaca-trade-api-cpp/alpaca/client.h"
+#include "ThirdParty/alpaca-trade-api-cpp/alpaca/config.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QDateTime>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+    struct AssetInfo {
+        std::string Id;
+        std::string Name;
+    };
+
+    // A symbol whose cached rows are recent enough to be used without fetching
+    struct CachedStock {
+        StockInformation Info;
+        bool Excluded = false;
+        bool Complete = false; // Has both a trade and a score row
+    };
+
+    bool loadFreshCache(QSqlDatabase& db, qint64 freshSince, std::unordered_map<std::string, CachedStock>& cachedStocks, QString& errorMessage) {
+        QSqlQuery cacheSelectQuery(db);
+
+        cacheSelectQuery.setForwardOnly(true);
+        cacheSelectQuery.prepare("SELECT stocks.symbol, stocks.name, stocks.excluded, trades.price, "
+                                 "scores.ma_score, scores.rsi_score, scores.bb_score, scores.total_score "
+                                 "FROM stocks "
+                                 "LEFT JOIN trades ON trades.symbol = stocks.symbol "
+                                 "LEFT JOIN scores ON scores.symbol = stocks.symbol "
+                                 "WHERE stocks.last_updated >= :freshSince "
+                                 "ORDER BY stocks.last_updated");
+        cacheSelectQuery.bindValue(":freshSince", freshSince);
+
+        if (!cacheSelectQuery.exec()) {
+            errorMessage = "Query execution failed:" + cacheSelectQuery.lastError().text();
+
+            return false;
+        }
+
+        while (cacheSelectQuery.next()) {
+            CachedStock cached;
+
+            cached.Info.Symbol = cacheSelectQuery.value(0).toString().toStdString();
+            cached.Info.Name = cacheSelectQuery.value(1).toString().toStdString();
+            cached.Excluded = cacheSelectQuery.value(2).toInt() != 0;
+            cached.Complete = !cacheSelectQuery.value(3).isNull() && !cacheSelectQuery.value(7).isNull();
+            cached.Info.Price = cacheSelectQuery.value(3).toDouble();
+            cached.Info.MA_Score = cacheSelectQuery.value(4).toDouble();
+            cached.Info.RSI_Score = cacheSelectQuery.value(5).toDouble();
+            cached.Info.BB_Score = cacheSelectQuery.value(6).toDouble();
+            cached.Info.Total_Score = cacheSelectQuery.value(7).toDouble();
+
+            // A symbol listed under more than one asset id keeps its most recently updated row
+            std::string symbol = cached.Info.Symbol;
+            cachedStocks.insert_or_assign(std::move(symbol), std::move(cached));
+        }
+
+        return true;
+    }
+
+    // Days of daily bars fetched and scored, longer than historyDays when a weighted indicator needs more bars
+    int scanHistoryDays(const ScanOptions& options) {
+        return std::max(options.historyDays, options.weights.historyDays());
+    }
+}
+
+// Constructor
+ScanEngine::ScanEngine(QSqlDatabase& database) : db(database) {}
+
+void ScanEngine::setCallbacks(ScanCallbacks scanCallbacks) {
+    callbacks = std::move(scanCallbacks);
+}
+
+const std::vector<StockInformation>& ScanEngine::results() const {
+    return scanResults;
+}
+
+const QString& ScanEngine::lastError() const {
+    return errorMessage;
+}
+
+bool ScanEngine::wasCancelled() const {
+    return cancelled;
+}
+
+const ScanMetrics* ScanEngine::metrics() const {
+    return activeMetrics;
+}
+
+bool ScanEngine::fail(const QString& message) {
+    errorMessage = message;
+
+    return false;
+}
+
+void ScanEngine::log(const std::string& message) {
+    if (callbacks.log)
+        callbacks.log(message);
+}
+
+bool ScanEngine::checkCancelled() {
+    if (!callbacks.cancelRequested || !callbacks.cancelRequested->load(std::memory_order_relaxed))
+        return false;
+
+    cancelled = true;
+    errorMessage = "Scan cancelled.";
+
+    return true;
+}
+
+void ScanEngine::reportProgress(const std::string& symbol) {
+    ++processedSymbols;
+
+    if (callbacks.progress)
+        callbacks.progress(processedSymbols, totalSymbols, symbol);
+}
+
+void ScanEngine::addResult(const StockInformation& info) {
+    if (activeSelector) {
+        activeSelector->offer(info);
+
+        return;
+    }
+
+    scanResults.push_back(info);
+
+    if (callbacks.resultReady)
+        callbacks.resultReady(info);
+}
+
+bool ScanEngine::run(const ScanOptions& options) {
+    scanResults.clear();
+    errorMessage.clear();
+    cancelled = false;
+    processedSymbols = 0;
+    totalSymbols = 0;
+    historyExclusions = 0;
+    scoreExclusions = 0;
+    activeMetrics = options.collectMetrics ? &scanMetrics : nullptr;
+
+    if (activeMetrics)
+        activeMetrics->reset();
+
+    auto started = std::chrono::steady_clock::now();
+
+    // All cache writes of a scan share these statements and are committed in batches
+    CacheWriter writer(db);
+
+    if (!writer.prepare())
+        return fail(writer.lastError());
+
+    CandidateSelector selector(options.candidates);
+
+    activeSelector = options.candidates.active() ? &selector : nullptr;
+
+    bool succeeded = scan(options, writer);
+
+    // The selection is only final once every symbol was offered, a cancelled scan reports the best it has seen
+    if (activeSelector) {
+        activeSelector = nullptr;
+
+        if (succeeded || cancelled) {
+            selector.take(scanResults);
+
+            if (callbacks.resultReady) {
+                for (const StockInformation& info : scanResults)
+                    callbacks.resultReady(info);
+            }
+        }
+    }
+
+    // A cancelled scan keeps what it already fetched, a failed one leaves the last batch uncommitted
+    if (succeeded || cancelled) {
+        ScanMetrics::StageTimer timer(activeMetrics, ScanStage::CacheWrite);
+
+        if (!writer.commit())
+            succeeded = fail(writer.lastError());
+    }
+
+    // Nothing to reconcile if the scan was served from the cache
+    if (succeeded && options.validateCache && writer.rowsWritten() > 0) {
+        ScanMetrics::StageTimer timer(activeMetrics, ScanStage::Validate);
+        PriceValidator validator(db);
+        PriceValidationOptions validation;
+
+        validation.windowBars = std::max(1, scanHistoryDays(options) * 5 / 7);
+        validation.scoreCeiling = options.exclusion.scoreCeiling;
+        validation.weights = options.weights;
+
+        // The scan itself already succeeded, a failed validation only leaves the cache as it was
+        if (validator.run(validation)) {
+            const PriceValidationStats& stats = validator.stats();
+
+            std::ostringstream summary;
+
+            summary << "Validated cache: " << stats.PricesCorrected << " prices corrected, " << stats.ScoresUpdated << " of "
+                    << stats.ScoresChecked << " suspicious scores updated, " << stats.SymbolsExcluded << " symbols excluded in "
+                    << stats.ElapsedMs << " ms";
+            log(summary.str());
+        } else {
+            log("Cache validation failed: " + validator.lastError().toStdString());
+        }
+    }
+
+    if (activeMetrics) {
+        activeMetrics->setRowsWritten(writer.rowsWritten());
+        activeMetrics->setTotalTime(std::chrono::steady_clock::now() - started);
+
+        // Metrics are diagnostics, failing to write them does not fail the scan
+        QString metricsError;
+
+        if (!options.metricsPath.empty() && !activeMetrics->save(QString::fromStdString(options.metricsPath), metricsError))
+            log(metricsError.toStdString());
+    }
+
+    return succeeded;
+}
+
+bool ScanEngine::scan(const ScanOptions& options, CacheWriter& writer) {
+    // Initialize Alpaca client for API request
+    alpaca::Environment env;
+    auto status = env.parse();
+
+    if (!status.ok())
+        return fail("Environment Error: " + QString::fromStdString(status.getMessage()));
+
+    alpaca::Client client(env);
+
+    // Fetch assets from Alpaca
+    auto assetsStarted = std::chrono::steady_clock::now();
+    auto [fetchStatus, assets] = client.getAssets(alpaca::AssetClass::USEquity, alpaca::ActionStatus::Active, options.exchange, options.userAgent);
+
+    if (activeMetrics) {
+        auto latency = std::chrono::steady_clock::now() - assetsStarted;
+
+        activeMetrics->addStageTime(ScanStage::Assets, latency);
+        activeMetrics->recordRequest(ApiEndpoint::Assets, latency, fetchStatus.ok(), FetchScheduler::httpStatusFromMessage(fetchStatus.getMessage()));
+    }
+
+    if (!fetchStatus.ok())
+        return fail("API Error: " + QString::fromStdString(fetchStatus.getMessage()));
+
+    // Gather symbols, keeping names and ids so they don't have to be fetched again per symbol
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, AssetInfo> assetsBySymbol;
+
+    assetsBySymbol.reserve(assets.size());
+
+    for (const auto& asset : assets) {
+        if (asset.tradable) {
+            symbols.push_back(asset.symbol); // Only add assets tradable on Alpaca
+            assetsBySymbol.insert_or_assign(asset.symbol, AssetInfo{ asset.id, asset.name });
+        }
+    }
+
+    // Everything still fresh in the cache comes back in one joined query
+    std::unordered_map<std::string, CachedStock> cachedStocks;
+    QString cacheError;
+
+    {
+        ScanMetrics::StageTimer timer(activeMetrics, ScanStage::CacheLookup);
+
+        if (!loadFreshCache(db, QDateTime::currentSecsSinceEpoch() - options.cacheLifetime, cachedStocks, cacheError))
+            return fail(cacheError);
+    }
+
+    std::vector<const CachedStock*> foundStocks;
+    std::vector<std::string> notFoundSymbols;
+
+    for (const std::string& symbol : symbols) {
+        auto cached = cachedStocks.find(symbol);
+
+        if (cached != cachedStocks.end())
+            foundStocks.push_back(&cached->second);
+        else
+            notFoundSymbols.push_back(symbol); // If symbol was not found or data was outdated, add to notFoundSymbols
+    }
+
+    if (activeMetrics)
+        activeMetrics->setCacheLookups(foundStocks.size(), notFoundSymbols.size());
+
+    ExclusionFilter filter(options.exclusion);
+
+    // Retrieve fresh asset data from the API for these symbols
+    if (!notFoundSymbols.empty()) {
+        BatchFetcher fetcher(env, options.userAgent, options.fetch, callbacks.cancelRequested);
+        std::unordered_map<std::string, TradeData> lastTrades;
+
+        fetcher.setMetrics(activeMetrics);
+
+        // Retrieve trade data
+        {
+            ScanMetrics::StageTimer timer(activeMetrics, ScanStage::LatestTrades);
+
+            fetcher.fetchLatestTrades(notFoundSymbols, lastTrades);
+        }
+
+        for (const std::string& message : fetcher.takeFailureMessages())
+            log(message);
+
+        if (checkCancelled())
+            return false;
+
+        // Only include stocks within the user's budget
+        std::vector<std::string> affordableSymbols;
+
+        for (const std::string& symbol : notFoundSymbols) {
+            auto it = lastTrades.find(symbol);
+
+            if (it != lastTrades.end() && it->second.Price <= options.budget)
+                affordableSymbols.push_back(symbol);
+        }
+
+        // Adjust date range to avoid recent SIP data
+        int period = scanHistoryDays(options);
+        QDateTime endDate = QDateTime::currentDateTime().addDays(-1); // Set endDate to 1 day ago
+        QDateTime startDate = endDate.addDays(-period); // Start date is period days before the adjusted end date
+
+        // Only request the bars each symbol is missing from the cache
+        std::unordered_map<std::string, SymbolBars> barsBySymbol;
+        BarSync barSync(db, fetcher);
+
+        {
+            ScanMetrics::StageTimer timer(activeMetrics, ScanStage::BarSync);
+
+            if (!barSync.sync(affordableSymbols, startDate.toSecsSinceEpoch(), endDate.toSecsSinceEpoch(), "1D", barsBySymbol))
+                return fail(barSync.lastError());
+        }
+
+        for (const std::string& message : fetcher.takeFailureMessages())
+            log(message);
+
+        if (checkCancelled())
+            return false;
+
+        // Symbols whose requests kept failing are left out of this scan instead of aborting it
+        const std::unordered_set<std::string>& failedSymbols = fetcher.failedSymbols();
+
+        if (!failedSymbols.empty()) {
+            log("Skipping " + std::to_string(failedSymbols.size()) + " symbols after repeated API errors");
+
+            affordableSymbols.erase(std::remove_if(affordableSymbols.begin(), affordableSymbols.end(), [&](const std::string& symbol) {
+                return failedSymbols.count(symbol) != 0;
+            }), affordableSymbols.end());
+        }
+
+        totalSymbols = static_cast<int>(affordableSymbols.size() + foundStocks.size());
+
+        FetchStats fetchStats = fetcher.stats();
+        const BarSyncStats& syncStats = barSync.stats();
+
+        std::ostringstream fetchSummary;
+        std::ostringstream syncSummary;
+
+        fetchSummary << "Fetched trades and bars for " << affordableSymbols.size() << " symbols in " << fetchStats.Requests << " requests ("
+                     << fetchStats.Retries << " retries, " << fetchStats.Failures << " failed, peak queue " << fetchStats.MaxQueueDepth
+                     << ", latency avg " << fetchStats.AverageLatencyMs << " ms, p95 " << fetchStats.P95LatencyMs << " ms)";
+        syncSummary << "Bar sync: " << syncStats.DeltaSymbols << " delta, " << syncStats.FullSymbols << " full, "
+                    << syncStats.AdjustedSymbols << " reloaded after adjustments";
+        log(fetchSummary.str());
+        log(syncSummary.str());
+
+        // Lay every window out in one columnar store so scoring reads contiguous closes instead of per-symbol copies
+        PriceStore windowStore;
+        std::vector<double> prices;
+        std::vector<ScoreCard> scoreCards;
+        ParallelScorer scorer(options.scoreThreads);
+
+        {
+            ScanMetrics::StageTimer timer(activeMetrics, ScanStage::Scoring);
+            std::size_t windowBars = 0;
+
+            for (const std::string& symbol : affordableSymbols)
+                windowBars += barsBySymbol.at(symbol).Window.size();
+
+            windowStore.reserve(affordableSymbols.size(), windowBars);
+
+            for (const std::string& symbol : affordableSymbols)
+                windowStore.append(symbol, barsBySymbol.at(symbol).Window);
+
+            // Score the whole universe across all cores, the loop below is the only thread that writes
+            prices.reserve(affordableSymbols.size());
+
+            for (const std::string& symbol : affordableSymbols)
+                prices.push_back(lastTrades.at(symbol).Price);
+
+            scorer.score(windowStore, prices, scoreCards, options.weights);
+        }
+
+        if (activeMetrics)
+            activeMetrics->setSymbolsScored(scoreCards.size());
+
+        const ParallelScorerStats& scorerStats = scorer.stats();
+
+        std::ostringstream scoreSummary;
+
+        scoreSummary << "Scored " << scoreCards.size() << " symbols on " << scorerStats.Threads << " threads in " << scorerStats.ElapsedMs
+                     << " ms (" << scorerStats.StolenChunks << " of " << scorerStats.Chunks << " chunks stolen, "
+                     << IndicatorKernels::levelName(IndicatorKernels::activeLevel()) << ")";
+        log(scoreSummary.str());
+
+        ScanMetrics::StageTimer writeTimer(activeMetrics, ScanStage::CacheWrite);
+
+        for (std::size_t symbolIndex = 0; symbolIndex < affordableSymbols.size(); ++symbolIndex) {
+            const std::string& symbol = affordableSymbols[symbolIndex];
+
+            if (checkCancelled())
+                return false;
+
+            reportProgress(symbol);
+
+            ScanMetrics::SymbolWriteTimer symbolTimer(activeMetrics);
+
+            if (!writer.nextSymbol())
+                return fail(writer.lastError());
+
+            const TradeData& lastTrade = lastTrades.at(symbol);
+            const AssetInfo& asset = assetsBySymbol.at(symbol);
+            double price = lastTrade.Price;
+
+            // Update the database
+            if (!writer.writeStock(asset.Id, asset.Name, symbol, QDateTime::currentSecsSinceEpoch()) || !writer.writeTrade(symbol, price, lastTrade.Size))
+                return fail(writer.lastError());
+
+            const SymbolBars& symbolBars = barsBySymbol.at(symbol);
+
+            // Update historical data in the database, adjusted history is replaced rather than mixed with new bars
+            if ((symbolBars.Replace && !writer.deleteBars(symbol)) || !writer.writeBars(symbol, symbolBars.Fresh))
+                return fail(writer.lastError());
+
+            if (windowStore.size(symbolIndex) == 0)
+                log("No bars found for symbol " + symbol + ", removing from analysis.");
+
+            const ScoreCard& scores = scoreCards[symbolIndex];
+
+            // Symbols without enough history are excluded from analysis
+            if (!scores.Valid || filter.checkHistory(windowStore.size(symbolIndex)) != ExclusionReason::None) {
+                if (!exclude(writer, symbol, ExclusionReason::InsufficientHistory))
+                    return false;
+
+                continue; // Skip to the next symbol
+            }
+
+            // Store score information for the results
+            StockInformation info;
+            info.Symbol = symbol;
+            info.Name = asset.Name;
+            info.Price = price;
+            info.MA_Score = scores.MA_Score;
+            info.RSI_Score = scores.RSI_Score;
+            info.BB_Score = scores.BB_Score;
+            info.Total_Score = scores.Total_Score;
+
+            if (!writer.writeScores(symbol, scores.MA_Score, scores.RSI_Score, scores.BB_Score, scores.Total_Score))
+                return fail(writer.lastError());
+
+            // Running sums for this window, later bars can then be folded in without rereading the history
+            std::span<const qint64> windowTimestamps = windowStore.timestamps(symbolIndex);
+            IndicatorState state = IndicatorState::fromSeries(windowStore.closes(symbolIndex), windowTimestamps.back());
+
+            if (!writer.writeIndicatorState(symbol, state))
+                return fail(writer.lastError());
+
+            ExclusionReason reason = filter.checkScore(scores.Total_Score);
+
+            if (reason != ExclusionReason::None) {
+                if (!exclude(writer, symbol, reason))
+                    return false;
+
+                continue;
+            }
+
+            addResult(info);
+        }
+    }
+
+    ScanMetrics::StageTimer finishTimer(activeMetrics, ScanStage::Finish);
+
+    // Symbols found valid in the cache, nothing is written back for them
+    if (totalSymbols == 0)
+        totalSymbols = static_cast<int>(foundStocks.size());
+
+    for (const CachedStock* cached : foundStocks) {
+        if (checkCancelled())
+            return false;
+
+        reportProgress(cached->Info.Symbol);
+
+        // Excluded by an earlier scan, or never scored
+        if (cached->Excluded || !cached->Complete)
+            continue;
+
+        // Score ceiling hits are flagged by the sweep below
+        if (filter.checkScore(cached->Info.Total_Score) != ExclusionReason::None) {
+            ++scoreExclusions;
+
+            continue;
+        }
+
+        addResult(cached->Info);
+    }
+
+    // One sweep for score rows of symbols this scan did not visit
+    if (!writer.excludeScoresAtOrAbove(filter.rules().scoreCeiling))
+        return fail(writer.lastError());
+
+    if (historyExclusions != 0 || scoreExclusions != 0) {
+        std::ostringstream summary;
+
+        summary << "Excluded " << historyExclusions << " symbols for short history and " << scoreExclusions
+                << " for scores at or above " << filter.rules().scoreCeiling;
+        log(summary.str());
+    }
+
+    return true;
+}
+
+bool ScanEngine::exclude(CacheWriter& writer, const std::string& symbol, ExclusionReason reason) {
+    if (!writer.markExcluded(symbol))
+        return fail(writer.lastError());
+
+    if (reason == ExclusionReason::InsufficientHistory)
+        ++historyExclusions;
+    else if (reason == ExclusionReason::ScoreCeiling)
+        ++scoreExclusions;
+
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef SCAN_ENGINE_H
+#define SCAN_ENGINE_H
+
+#include "CandidateSelector.h"
+#include "ExclusionFilter.h"
+#include "FetchScheduler.h"
+#include "ScanMetrics.h"
+#include "Analysis/StockAnalysis.h"
+
+#include <QString>
+#include <QSqlDatabase>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ScanOptions {
+    double budget = 0.0;
+    std::string exchange = "NYSE";
+    std::string userAgent = "StockHound/1.0";
+    int historyDays = 40;            // Days of daily bars requested per symbol, more if the weights need them
+    qint64 cacheLifetime = 172800;   // Cached data is only considered valid for 48 hours
+    FetchSchedulerOptions fetch;     // Concurrency, rate limit and retry policy for API requests
+    unsigned scoreThreads = 0;       // Threads used for scoring, 0 uses every core
+    ExclusionRules exclusion;        // Symbols dropped from the results after scoring
+    CandidateLimits candidates;      // Keep only the best results, optionally capped per sector, every result by default
+    ScoreWeights weights;            // Indicator weights of the total score, MA 40%, RSI 30%, BB 30% by default
+    bool collectMetrics = false;     // Stage timings, request latencies and cache counters, see ScanEngine::metrics()
+    std::string metricsPath;         // Metrics are written here after every scan that collects them, .json or Prometheus text
+    bool validateCache = true;       // Reconcile cached prices and suspicious scores after a scan that wrote new data
+};
+
+struct StockInformation {
+    std::string Symbol;
+    std::string Name;
+    double Price;
+    double MA_Score;
+    double RSI_Score;
+    double BB_Score;
+    double Total_Score;
+};
+
+class CacheWriter;
+
+// Hooks used by callers that run the scan in the background
+struct ScanCallbacks {
+    std::function<void(int processed, int total, const std::string& symbol)> progress;
+    std::function<void(const std::string& message)> log;   // Stage summaries and warnings, the engine itself never prints
+    std::function<void(const StockInformation& info)> resultReady;   // With candidate limits only for the selection, once the scan ends
+    const std::atomic<bool>* cancelRequested = nullptr; // Checked between symbols
+};
+
+// Runs the fetch -> cache -> score -> filter pipeline without any UI dependency
+class ScanEngine {
+public:
+    // Constructor
+    explicit ScanEngine(QSqlDatabase& database);
+
+    void setCallbacks(ScanCallbacks scanCallbacks);
+
+    // Returns false if the scan was aborted or cancelled, lastError() holds the reason
+    bool run(const ScanOptions& options);
+
+    // Every result in the order found, or the candidate selection best first when options.candidates limits it
+    const std::vector<StockInformation>& results() const;
+    const QString& lastError() const;
+    bool wasCancelled() const;
+
+    // Null unless the last scan collected metrics
+    const ScanMetrics* metrics() const;
+
+private:
+    QSqlDatabase& db;
+
+    ScanCallbacks callbacks;
+    std::vector<StockInformation> scanResults;
+    QString errorMessage;
+    bool cancelled = false;
+    int processedSymbols = 0;
+    int totalSymbols = 0;
+    int historyExclusions = 0;
+    int scoreExclusions = 0;
+
+    ScanMetrics scanMetrics;
+    ScanMetrics* activeMetrics = nullptr;   // Points at scanMetrics while collecting, null otherwise
+    CandidateSelector* activeSelector = nullptr;   // Set while a scan limits its candidates
+
+    bool scan(const ScanOptions& options, CacheWriter& writer);
+    bool fail(const QString& message);
+    void log(const std::string& message);
+    bool checkCancelled();
+    void reportProgress(const std::string& symbol);
+    void addResult(const StockInformation& info);
+    bool exclude(CacheWriter& writer, const std::string& symbol, ExclusionReason reason);
+};
+
+#endif // SCAN_ENGINE_H
@@ -0,0 +1,390 @@
+#include "ScanMetrics.h"
+
+#include <QSaveFile>
+#include <QStringList>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr double nsPerSecond = 1e9;
+
+    double seconds(std::int64_t ns) {
+        return static_cast<double>(ns) / nsPerSecond;
+    }
+
+    template <typename Enum>
+    constexpr std::size_t indexOf(Enum value) {
+        return static_cast<std::size_t>(value);
+    }
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+    const std::uint64_t ns = static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count()));
+    const double value = static_cast<double>(ns) / nsPerSecond;
+    const std::size_t bucket = static_cast<std::size_t>(std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin());
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    sumNs.fetch_add(ns, std::memory_order_relaxed);
+
+    std::uint64_t currentMax = maxNs.load(std::memory_order_relaxed);
+
+    while (ns > currentMax && !maxNs.compare_exchange_weak(currentMax, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::clear() {
+    for (std::atomic<std::uint64_t>& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+
+    sumNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::count() const {
+    std::uint64_t total = 0;
+
+    for (const std::atomic<std::uint64_t>& bucket : buckets)
+        total += bucket.load(std::memory_order_relaxed);
+
+    return total;
+}
+
+double LatencyHistogram::sumSeconds() const {
+    return static_cast<double>(sumNs.load(std::memory_order_relaxed)) / nsPerSecond;
+}
+
+double LatencyHistogram::maxSeconds() const {
+    return static_cast<double>(maxNs.load(std::memory_order_relaxed)) / nsPerSecond;
+}
+
+std::array<std::uint64_t, LatencyHistogram::bounds.size() + 1> LatencyHistogram::cumulativeCounts() const {
+    std::array<std::uint64_t, bounds.size() + 1> cumulative{};
+    std::uint64_t running = 0;
+
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        running += buckets[i].load(std::memory_order_relaxed);
+        cumulative[i] = running;
+    }
+
+    return cumulative;
+}
+
+double LatencyHistogram::quantileSeconds(double quantile) const {
+    const auto cumulative = cumulativeCounts();
+    const std::uint64_t total = cumulative.back();
+
+    if (total == 0)
+        return 0.0;
+
+    const double rank = std::clamp(quantile, 0.0, 1.0) * static_cast<double>(total);
+
+    for (std::size_t i = 0; i < bounds.size(); ++i)
+        if (static_cast<double>(cumulative[i]) >= rank)
+            return bounds[i];
+
+    // Beyond the last bound, the largest observation is the best estimate there is
+    return maxSeconds();
+}
+
+ScanMetrics::StageTimer::StageTimer(ScanMetrics* scanMetrics, ScanStage scanStage) : metrics(scanMetrics), stage(scanStage) {
+    if (metrics)
+        started = std::chrono::steady_clock::now();
+}
+
+ScanMetrics::StageTimer::~StageTimer() {
+    if (metrics)
+        metrics->addStageTime(stage, std::chrono::steady_clock::now() - started);
+}
+
+ScanMetrics::SymbolWriteTimer::SymbolWriteTimer(ScanMetrics* scanMetrics) : metrics(scanMetrics) {
+    if (metrics)
+        started = std::chrono::steady_clock::now();
+}
+
+ScanMetrics::SymbolWriteTimer::~SymbolWriteTimer() {
+    if (metrics)
+        metrics->recordSymbolWrite(std::chrono::steady_clock::now() - started);
+}
+
+void ScanMetrics::reset() {
+    stageNs.fill(0);
+
+    for (EndpointCounters& endpoint : endpoints) {
+        endpoint.Latency.clear();
+        endpoint.Errors = 0;
+        endpoint.Throttled = 0;
+    }
+
+    symbolWrites.clear();
+
+    cacheHits = 0;
+    cacheMisses = 0;
+    rowsWritten = 0;
+    symbolsScored = 0;
+    totalNs = 0;
+}
+
+void ScanMetrics::addStageTime(ScanStage stage, std::chrono::nanoseconds duration) {
+    stageNs[indexOf(stage)] += duration.count();
+}
+
+void ScanMetrics::recordRequest(ApiEndpoint endpoint, std::chrono::nanoseconds latency, bool ok, int httpStatus) {
+    EndpointCounters& counters = endpoints[indexOf(endpoint)];
+
+    counters.Latency.record(latency);
+
+    if (!ok)
+        counters.Errors.fetch_add(1, std::memory_order_relaxed);
+
+    if (httpStatus == 429)
+        counters.Throttled.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ScanMetrics::recordSymbolWrite(std::chrono::nanoseconds duration) {
+    symbolWrites.record(duration);
+}
+
+void ScanMetrics::setCacheLookups(std::size_t hits, std::size_t misses) {
+    cacheHits = hits;
+    cacheMisses = misses;
+}
+
+void ScanMetrics::setRowsWritten(std::int64_t rows) {
+    rowsWritten = rows;
+}
+
+void ScanMetrics::setSymbolsScored(std::size_t symbols) {
+    symbolsScored = symbols;
+}
+
+void ScanMetrics::setTotalTime(std::chrono::nanoseconds duration) {
+    totalNs = duration.count();
+}
+
+double ScanMetrics::stageSeconds(ScanStage stage) const {
+    return seconds(stageNs[indexOf(stage)]);
+}
+
+const LatencyHistogram& ScanMetrics::requestLatency(ApiEndpoint endpoint) const {
+    return endpoints[indexOf(endpoint)].Latency;
+}
+
+const char* ScanMetrics::stageName(ScanStage stage) {
+    switch (stage) {
+    case ScanStage::Assets:       return "assets";
+    case ScanStage::CacheLookup:  return "cache_lookup";
+    case ScanStage::LatestTrades: return "trades";
+    case ScanStage::BarSync:      return "bars";
+    case ScanStage::Scoring:      return "scoring";
+    case ScanStage::CacheWrite:   return "cache_write";
+    case ScanStage::Finish:       return "finish";
+    case ScanStage::Validate:     return "validate";
+    case ScanStage::Count:        break;
+    }
+
+    return "unknown";
+}
+
+const char* ScanMetrics::endpointName(ApiEndpoint endpoint) {
+    switch (endpoint) {
+    case ApiEndpoint::Assets:       return "assets";
+    case ApiEndpoint::LatestTrades: return "trades_latest";
+    case ApiEndpoint::Bars:         return "bars";
+    case ApiEndpoint::Count:        break;
+    }
+
+    return "unknown";
+}
+
+QString ScanMetrics::summary() const {
+    QStringList stages;
+
+    // Slowest stages first, anything under 10 ms is noise on a status bar
+    std::array<std::size_t, static_cast<std::size_t>(ScanStage::Count)> order{};
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return stageNs[a] > stageNs[b]; });
+
+    for (std::size_t i : order) {
+        if (stageNs[i] >= 10000000)
+            stages << QString("%1 %2 s").arg(stageName(static_cast<ScanStage>(i))).arg(seconds(stageNs[i]), 0, 'f', 2);
+    }
+
+    std::uint64_t requests = 0;
+    std::uint64_t errors = 0;
+    double latencySum = 0.0;
+
+    for (const EndpointCounters& endpoint : endpoints) {
+        requests += endpoint.Latency.count();
+        errors += endpoint.Errors.load(std::memory_order_relaxed);
+        latencySum += endpoint.Latency.sumSeconds();
+    }
+
+    QString text = stages.isEmpty() ? QString("all stages under 10 ms") : stages.join(", ");
+
+    if (requests > 0)
+        text += QString(" | %1 requests, %2 failed, avg %3 ms").arg(requests).arg(errors).arg(latencySum * 1000.0 / static_cast<double>(requests), 0, 'f', 0);
+
+    if (cacheHits + cacheMisses > 0)
+        text += QString(" | cache %1% hit").arg(100.0 * static_cast<double>(cacheHits) / static_cast<double>(cacheHits + cacheMisses), 0, 'f', 0);
+
+    return text;
+}
+
+void ScanMetrics::writePrometheus(std::ostream& out) const {
+    using LabelledHistogram = std::pair<std::string, const LatencyHistogram*>;
+
+    // Every value covers the last scan only and starts from zero at the next one, so all of them are gauges. A counter
+    // would read as reset at every scan. Latencies keep the bucket layout, histogram_quantile() reads le labels of gauges too.
+    auto labelled = [](const std::string& name, const std::string& labels) {
+        return labels.empty() ? name : name + "{" + labels + "}";
+    };
+
+    auto writeGauge = [&out](const std::string& name, const std::string& help) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << " gauge\n";
+    };
+
+    auto writeHistogram = [&](const std::string& name, const std::string& help, const std::vector<LabelledHistogram>& series) {
+        writeGauge(name + "_bucket", help + ", observations at or below le.");
+
+        for (const auto& [labels, histogram] : series) {
+            const auto cumulative = histogram->cumulativeCounts();
+            const std::string prefix = name + "_bucket{" + labels + (labels.empty() ? "" : ",");
+
+            for (std::size_t i = 0; i < LatencyHistogram::bounds.size(); ++i)
+                out << prefix << "le=\"" << LatencyHistogram::bounds[i] << "\"} " << cumulative[i] << '\n';
+
+            out << prefix << "le=\"+Inf\"} " << cumulative.back() << '\n';
+        }
+
+        writeGauge(name + "_sum", help + ", summed.");
+
+        for (const auto& [labels, histogram] : series)
+            out << labelled(name + "_sum", labels) << ' ' << histogram->sumSeconds() << '\n';
+
+        writeGauge(name + "_count", help + ", observations.");
+
+        for (const auto& [labels, histogram] : series)
+            out << labelled(name + "_count", labels) << ' ' << histogram->cumulativeCounts().back() << '\n';
+    };
+
+    writeGauge("stockhound_scan_duration_seconds", "Wall time of the last scan.");
+    out << "stockhound_scan_duration_seconds " << seconds(totalNs) << '\n';
+
+    writeGauge("stockhound_scan_stage_seconds", "Wall time of each stage of the last scan.");
+
+    for (std::size_t i = 0; i < stageNs.size(); ++i)
+        out << "stockhound_scan_stage_seconds{stage=\"" << stageName(static_cast<ScanStage>(i)) << "\"} " << seconds(stageNs[i]) << '\n';
+
+    std::vector<LabelledHistogram> requestLatencies;
+
+    for (std::size_t i = 0; i < endpoints.size(); ++i)
+        requestLatencies.emplace_back(std::string("endpoint=\"") + endpointName(static_cast<ApiEndpoint>(i)) + "\"", &endpoints[i].Latency);
+
+    writeHistogram("stockhound_scan_api_request_duration_seconds", "Latency of API requests in the last scan, including response parsing",
+                   requestLatencies);
+
+    writeGauge("stockhound_scan_api_request_errors", "Failed API requests in the last scan, retries included.");
+
+    for (std::size_t i = 0; i < endpoints.size(); ++i) {
+        const char* endpoint = endpointName(static_cast<ApiEndpoint>(i));
+        std::uint64_t throttled = endpoints[i].Throttled.load(std::memory_order_relaxed);
+
+        out << "stockhound_scan_api_request_errors{endpoint=\"" << endpoint << "\",reason=\"throttled\"} " << throttled << '\n'
+            << "stockhound_scan_api_request_errors{endpoint=\"" << endpoint << "\",reason=\"other\"} "
+            << endpoints[i].Errors.load(std::memory_order_relaxed) - throttled << '\n';
+    }
+
+    writeHistogram("stockhound_scan_symbol_write_duration_seconds", "Time spent writing one symbol to the cache in the last scan",
+                   { LabelledHistogram(std::string(), &symbolWrites) });
+
+    writeGauge("stockhound_scan_cache_lookups", "Symbols the last scan served from the cache or fetched from the API.");
+    out << "stockhound_scan_cache_lookups{result=\"hit\"} " << cacheHits << '\n'
+        << "stockhound_scan_cache_lookups{result=\"miss\"} " << cacheMisses << '\n';
+
+    writeGauge("stockhound_scan_db_rows_written", "Rows the last scan inserted, replaced or updated in the cache.");
+    out << "stockhound_scan_db_rows_written " << rowsWritten << '\n';
+
+    writeGauge("stockhound_scan_symbols_scored", "Symbols the last scan scored from fetched bars.");
+    out << "stockhound_scan_symbols_scored " << symbolsScored << '\n';
+}
+
+void ScanMetrics::writeJson(std::ostream& out) const {
+    auto histogramJson = [](const LatencyHistogram& histogram) {
+        nlohmann::json buckets = nlohmann::json::array();
+        const auto cumulative = histogram.cumulativeCounts();
+
+        for (std::size_t i = 0; i < LatencyHistogram::bounds.size(); ++i)
+            buckets.push_back({ {"le", LatencyHistogram::bounds[i]}, {"count", cumulative[i]} });
+
+        buckets.push_back({ {"le", "+Inf"}, {"count", cumulative.back()} });
+
+        return nlohmann::json{
+            {"count", cumulative.back()},
+            {"sum_seconds", histogram.sumSeconds()},
+            {"max_seconds", histogram.maxSeconds()},
+            {"p50_seconds", histogram.quantileSeconds(0.5)},
+            {"p95_seconds", histogram.quantileSeconds(0.95)},
+            {"buckets", buckets}
+        };
+    };
+
+    nlohmann::json stages = nlohmann::json::object();
+    nlohmann::json requests = nlohmann::json::object();
+
+    for (std::size_t i = 0; i < stageNs.size(); ++i)
+        stages[stageName(static_cast<ScanStage>(i))] = seconds(stageNs[i]);
+
+    for (std::size_t i = 0; i < endpoints.size(); ++i) {
+        nlohmann::json endpoint = histogramJson(endpoints[i].Latency);
+
+        endpoint["errors"] = endpoints[i].Errors.load(std::memory_order_relaxed);
+        endpoint["throttled"] = endpoints[i].Throttled.load(std::memory_order_relaxed);
+        requests[endpointName(static_cast<ApiEndpoint>(i))] = endpoint;
+    }
+
+    nlohmann::json document = {
+        {"duration_seconds", seconds(totalNs)},
+        {"stages", stages},
+        {"requests", requests},
+        {"symbol_writes", histogramJson(symbolWrites)},
+        {"cache", { {"hits", cacheHits}, {"misses", cacheMisses} }},
+        {"rows_written", rowsWritten},
+        {"symbols_scored", symbolsScored}
+    };
+
+    out << document.dump(2) << '\n';
+}
+
+bool ScanMetrics::save(const QString& path, QString& errorMessage) const {
+    std::ostringstream text;
+
+    if (path.endsWith(".json", Qt::CaseInsensitive))
+        writeJson(text);
+    else
+        writePrometheus(text);
+
+    // Scrapers such as the node exporter's textfile collector may read the file at any moment
+    QSaveFile file(path);
+    const std::string content = text.str();
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorMessage = "Failed to write metrics: " + file.errorString();
+
+        return false;
+    }
+
+    file.write(content.data(), static_cast<qint64>(content.size()));
+
+    if (!file.commit()) {
+        errorMessage = "Failed to write metrics: " + file.errorString();
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,139 @@
+#ifndef SCAN_METRICS_H
+#define SCAN_METRICS_H
+
+#include <QString>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+enum class ScanStage {
+    Assets,         // Asset listing request
+    CacheLookup,    // Joined query for symbols still fresh in the cache
+    LatestTrades,   // Latest trade requests
+    BarSync,        // Stored bar lookups plus the bar requests for what is missing
+    Scoring,        // Window layout and parallel scoring
+    CacheWrite,     // Per-symbol cache writes and the final commit
+    Finish,         // Cached results and the exclusion sweep
+    Validate,       // Price and score reconciliation after the commit
+    Count
+};
+
+enum class ApiEndpoint {
+    Assets,
+    LatestTrades,
+    Bars,
+    Count
+};
+
+// Cumulative histogram with fixed bounds in seconds, safe to record into from any thread
+class LatencyHistogram {
+public:
+    static constexpr std::array<double, 16> bounds = { 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                                       0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+
+    void record(std::chrono::nanoseconds duration);
+
+    // Not safe while other threads record
+    void clear();
+
+    std::uint64_t count() const;
+    double sumSeconds() const;
+    double maxSeconds() const;
+
+    // Upper bound of the bucket holding the given quantile, an overestimate by at most one bucket
+    double quantileSeconds(double quantile) const;
+
+    // Observations at or below bounds[i], the last entry counts everything
+    std::array<std::uint64_t, bounds.size() + 1> cumulativeCounts() const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, bounds.size() + 1> buckets{};
+    std::atomic<std::uint64_t> sumNs{0};
+    std::atomic<std::uint64_t> maxNs{0};
+};
+
+// Counters, stage timers and latency histograms of one scan. Components receive a pointer to it and skip every
+// measurement when that pointer is null, so a scan without metrics pays one branch per call site.
+class ScanMetrics {
+public:
+    // Adds the time from construction to destruction to a stage, does nothing without metrics
+    class StageTimer {
+    public:
+        StageTimer(ScanMetrics* scanMetrics, ScanStage scanStage);
+        ~StageTimer();
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+    private:
+        ScanMetrics* metrics;
+        ScanStage stage;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    // Records the time from construction to destruction as one symbol write, does nothing without metrics
+    class SymbolWriteTimer {
+    public:
+        explicit SymbolWriteTimer(ScanMetrics* scanMetrics);
+        ~SymbolWriteTimer();
+
+        SymbolWriteTimer(const SymbolWriteTimer&) = delete;
+        SymbolWriteTimer& operator=(const SymbolWriteTimer&) = delete;
+
+    private:
+        ScanMetrics* metrics;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    void reset();
+
+    void addStageTime(ScanStage stage, std::chrono::nanoseconds duration);
+
+    // One attempt against the API, retries count as separate requests
+    void recordRequest(ApiEndpoint endpoint, std::chrono::nanoseconds latency, bool ok, int httpStatus);
+
+    // All cache writes of one symbol
+    void recordSymbolWrite(std::chrono::nanoseconds duration);
+
+    void setCacheLookups(std::size_t hits, std::size_t misses);
+    void setRowsWritten(std::int64_t rows);
+    void setSymbolsScored(std::size_t symbols);
+    void setTotalTime(std::chrono::nanoseconds duration);
+
+    double stageSeconds(ScanStage stage) const;
+    const LatencyHistogram& requestLatency(ApiEndpoint endpoint) const;
+
+    // One line for a status bar, e.g. "bars 8.1 s, trades 1.2 s ... | 412 requests, avg 180 ms | cache 73% hit"
+    QString summary() const;
+
+    void writePrometheus(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+
+    // Replaces the file atomically, JSON if the name ends in .json and Prometheus text otherwise
+    bool save(const QString& path, QString& errorMessage) const;
+
+    static const char* stageName(ScanStage stage);
+    static const char* endpointName(ApiEndpoint endpoint);
+
+private:
+    struct EndpointCounters {
+        LatencyHistogram Latency;
+        std::atomic<std::uint64_t> Errors{0};
+        std::atomic<std::uint64_t> Throttled{0};   // HTTP 429, also counted as errors
+    };
+
+    std::array<std::int64_t, static_cast<std::size_t>(ScanStage::Count)> stageNs{};
+    std::array<EndpointCounters, static_cast<std::size_t>(ApiEndpoint::Count)> endpoints;
+    LatencyHistogram symbolWrites;
+
+    std::size_t cacheHits = 0;
+    std::size_t cacheMisses = 0;
+    std::int64_t rowsWritten = 0;
+    std::size_t symbolsScored = 0;
+    std::int64_t totalNs = 0;
+};
+
+#endif // SCAN_METRICS_H
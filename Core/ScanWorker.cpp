@@ -0,0 +1,63 @@
+#include "ScanWorker.h"
+#include "Database/CacheDatabase.h"
+
+#include <QSqlDatabase>
+
+namespace {
+    // Each worker thread needs its own connection, Qt connections can't be shared across threads
+    const QString workerConnectionName = QStringLiteral("scan-worker");
+}
+
+ScanWorker::ScanWorker(const QString& databasePath, const ScanOptions& options, QObject* parent)
+    : QObject(parent), dbPath(databasePath), scanOptions(options) {
+    qRegisterMetaType<StockInformation>();
+}
+
+void ScanWorker::cancel() {
+    cancelRequested.store(true, std::memory_order_relaxed);
+}
+
+void ScanWorker::run() {
+    bool cancelled = false;
+
+    {
+        QSqlDatabase db;
+        QString errorMessage;
+
+        if (!CacheDatabase::open(db, dbPath, workerConnectionName, errorMessage)) {
+            emit failed(errorMessage);
+        }
+        else {
+            ScanEngine engine(db);
+            ScanCallbacks callbacks;
+
+            callbacks.progress = [this](int processed, int total, const std::string& symbol) {
+                emit progress(processed, total, QString::fromStdString(symbol));
+            };
+            callbacks.log = [this](const std::string& message) {
+                emit logMessage(QString::fromStdString(message));
+            };
+            callbacks.resultReady = [this](const StockInformation& info) {
+                emit resultReady(info);
+            };
+            callbacks.cancelRequested = &cancelRequested;
+
+            engine.setCallbacks(std::move(callbacks));
+
+            if (!engine.run(scanOptions) && !engine.wasCancelled())
+                emit failed(engine.lastError());
+
+            if (engine.metrics())
+                emit metricsReady(engine.metrics()->summary());
+
+            cancelled = engine.wasCancelled();
+        }
+
+        db.close();
+    }
+
+    // The connection may only be removed once no QSqlDatabase handle refers to it anymore
+    QSqlDatabase::removeDatabase(workerConnectionName);
+
+    emit finished(cancelled);
+}
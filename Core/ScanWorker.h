@@ -0,0 +1,39 @@
+#ifndef SCAN_WORKER_H
+#define SCAN_WORKER_H
+
+#include "ScanEngine.h"
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+
+Q_DECLARE_METATYPE(StockInformation)
+
+// Runs a ScanEngine on whichever thread it has been moved to and reports back through queued signals
+class ScanWorker : public QObject {
+    Q_OBJECT
+
+public:
+    ScanWorker(const QString& databasePath, const ScanOptions& options, QObject* parent = nullptr);
+
+    // Safe to call from any thread, the scan stops before the next symbol
+    void cancel();
+
+public slots:
+    void run();
+
+signals:
+    void progress(int processed, int total, const QString& symbol);
+    void logMessage(const QString& message);   // Stage summaries and warnings of the scan
+    void resultReady(const StockInformation& info);
+    void failed(const QString& message);
+    void metricsReady(const QString& summary);   // Sent before finished() when the scan collected metrics
+    void finished(bool cancelled);
+
+private:
+    QString dbPath;
+    ScanOptions scanOptions;
+    std::atomic<bool> cancelRequested{false};
+};
+
+#endif // SCAN_WORKER_H
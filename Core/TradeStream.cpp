@@ -0,0 +1,183 @@
+#include "TradeStream.h"
+
+#include <QDateTime>
+#include <QUrl>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+
+namespace {
+    // Fields of the wrong type read as missing, value() would throw out of the slot instead
+    std::string stringField(const nlohmann::json& entry, const char* key) {
+        auto field = entry.find(key);
+
+        return field != entry.end() && field->is_string() ? field->get<std::string>() : std::string();
+    }
+
+    double numberField(const nlohmann::json& entry, const char* key) {
+        auto field = entry.find(key);
+
+        return field != entry.end() && field->is_number() ? field->get<double>() : 0.0;
+    }
+}
+
+TradeStream::TradeStream(const TradeStreamOptions& options, QObject* parent)
+    : QObject(parent), streamOptions(options), socket(QString(), QWebSocketProtocol::VersionLatest, this) {
+    flushTimer.setInterval(std::max(1, streamOptions.flushIntervalMs));
+    reconnectTimer.setSingleShot(true);
+
+    connect(&socket, &QWebSocket::connected, this, &TradeStream::onConnected);
+    connect(&socket, &QWebSocket::disconnected, this, &TradeStream::onDisconnected);
+    connect(&socket, &QWebSocket::textMessageReceived, this, &TradeStream::onTextMessageReceived);
+    connect(&flushTimer, &QTimer::timeout, this, &TradeStream::flush);
+    connect(&reconnectTimer, &QTimer::timeout, this, [this]() {
+        if (running)
+            socket.open(QUrl(streamOptions.url));
+    });
+}
+
+TradeStreamOptions TradeStream::optionsFromEnvironment() {
+    TradeStreamOptions options;
+    QString url = qEnvironmentVariable("APCA_API_STREAM_URL");
+
+    if (!url.isEmpty())
+        options.url = url;
+
+    options.keyId = qEnvironmentVariable("APCA_API_KEY_ID");
+    options.secretKey = qEnvironmentVariable("APCA_API_SECRET_KEY");
+
+    return options;
+}
+
+qint64 TradeStream::ticksReceived() const {
+    return receivedTicks;
+}
+
+void TradeStream::start(const QStringList& symbols) {
+    subscribedSymbols = symbols;
+    running = true;
+    reconnectDelay = streamOptions.reconnectDelayMs;
+
+    emit statusChanged("Connecting to " + streamOptions.url);
+    socket.open(QUrl(streamOptions.url));
+    flushTimer.start();
+}
+
+void TradeStream::stop() {
+    running = false;
+    reconnectTimer.stop();
+    flushTimer.stop();
+    flush();
+    socket.close();
+}
+
+void TradeStream::send(const std::string& message) {
+    socket.sendTextMessage(QString::fromStdString(message));
+}
+
+void TradeStream::onConnected() {
+    // The server greets with a "connected" message first, authentication follows from there
+    reconnectDelay = streamOptions.reconnectDelayMs;
+    emit statusChanged("Connected, authenticating");
+}
+
+void TradeStream::onDisconnected() {
+    if (running)
+        scheduleReconnect();
+}
+
+void TradeStream::scheduleReconnect() {
+    emit statusChanged(QString("Stream disconnected, retrying in %1 s").arg(reconnectDelay / 1000.0, 0, 'f', 1));
+    reconnectTimer.start(reconnectDelay);
+    reconnectDelay = std::min(reconnectDelay * 2, streamOptions.maxReconnectDelayMs);
+}
+
+void TradeStream::onTextMessageReceived(const QString& message) {
+    nlohmann::json messages = nlohmann::json::parse(message.toStdString(), nullptr, false);
+
+    if (messages.is_discarded())
+        return;
+
+    // Every frame is an array of messages, a lone object is accepted as well
+    if (!messages.is_array())
+        messages = nlohmann::json::array({ messages });
+
+    for (const nlohmann::json& entry : messages) {
+        if (!entry.is_object())
+            continue;
+
+        std::string type = stringField(entry, "T");
+
+        if (type == "t") {
+            TradeTick tick;
+
+            tick.Symbol = stringField(entry, "S");
+            tick.Price = numberField(entry, "p");
+            tick.Size = static_cast<qint64>(numberField(entry, "s"));
+            tick.Timestamp = QDateTime::fromString(QString::fromStdString(stringField(entry, "t")), Qt::ISODateWithMs).toMSecsSinceEpoch();
+
+            ++receivedTicks;
+
+            if (tick.Symbol.empty() || tick.Price <= 0)
+                continue;
+
+            // Keep the newest trade, the feed may deliver slightly out of order
+            auto pending = pendingTicks.find(tick.Symbol);
+
+            if (pending == pendingTicks.end())
+                pendingTicks.emplace(tick.Symbol, std::move(tick));
+            else if (tick.Timestamp >= pending->second.Timestamp)
+                pending->second = std::move(tick);
+        }
+        else if (type == "success") {
+            std::string status = stringField(entry, "msg");
+
+            if (status == "connected") {
+                send(nlohmann::json{ { "action", "auth" }, { "key", streamOptions.keyId.toStdString() }, { "secret", streamOptions.secretKey.toStdString() } }.dump());
+            }
+            else if (status == "authenticated") {
+                std::vector<std::string> symbols;
+
+                for (const QString& symbol : subscribedSymbols)
+                    symbols.push_back(symbol.toStdString());
+
+                send(nlohmann::json{ { "action", "subscribe" }, { "trades", symbols } }.dump());
+            }
+        }
+        else if (type == "subscription") {
+            auto trades = entry.find("trades");
+            std::size_t count = trades != entry.end() && trades->is_array() ? trades->size() : 0;
+
+            emit statusChanged(QString("Streaming trades for %1 symbols").arg(count));
+        }
+        else if (type == "error") {
+            int code = static_cast<int>(numberField(entry, "code"));
+            QString errorMessage = QString("Stream error %1: %2").arg(code).arg(QString::fromStdString(stringField(entry, "msg")));
+
+            emit failed(errorMessage);
+
+            // Bad credentials or a plan without this feed won't get better by reconnecting
+            if (code == 401 || code == 402 || code == 409) {
+                stop();
+                emit closed();
+
+                return;
+            }
+        }
+    }
+}
+
+void TradeStream::flush() {
+    if (pendingTicks.empty())
+        return;
+
+    std::vector<TradeTick> ticks;
+
+    ticks.reserve(pendingTicks.size());
+
+    for (auto& [symbol, tick] : pendingTicks)
+        ticks.push_back(std::move(tick));
+
+    pendingTicks.clear();
+
+    emit ticksReady(ticks);
+}
@@ -0,0 +1,74 @@
+#ifndef TRADE_STREAM_H
+#define TRADE_STREAM_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QWebSocket>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TradeTick {
+    std::string Symbol;
+    double Price = 0.0;
+    qint64 Size = 0;
+    qint64 Timestamp = 0; // Milliseconds since epoch
+};
+
+struct TradeStreamOptions {
+    QString url = QStringLiteral("wss://stream.data.alpaca.markets/v2/iex");
+    QString keyId;
+    QString secretKey;
+    int flushIntervalMs = 500;          // Ticks are coalesced per symbol and handed on at most this often
+    int reconnectDelayMs = 1000;        // First retry after a dropped connection, doubled up to the maximum
+    int maxReconnectDelayMs = 30000;
+};
+
+// Real-time trades from the Alpaca market data websocket. Only the newest tick per symbol is kept between flushes, so a
+// burst of trades costs one update per symbol instead of one per trade.
+class TradeStream : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TradeStream(const TradeStreamOptions& options, QObject* parent = nullptr);
+
+    // Keys from APCA_API_KEY_ID/APCA_API_SECRET_KEY, the feed URL from APCA_API_STREAM_URL when set
+    static TradeStreamOptions optionsFromEnvironment();
+
+    void start(const QStringList& symbols);
+    void stop();
+
+    qint64 ticksReceived() const;
+
+signals:
+    void ticksReady(const std::vector<TradeTick>& ticks);
+    void statusChanged(const QString& status);
+    void failed(const QString& message);
+
+    // The stream gave up for good, e.g. after an authentication error, and will not reconnect. stop() does not emit it.
+    void closed();
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onTextMessageReceived(const QString& message);
+    void flush();
+
+private:
+    TradeStreamOptions streamOptions;
+    QWebSocket socket;
+    QTimer flushTimer;
+    QTimer reconnectTimer;
+    QStringList subscribedSymbols;
+    std::unordered_map<std::string, TradeTick> pendingTicks;
+    qint64 receivedTicks = 0;
+    int reconnectDelay = 0;
+    bool running = false;
+
+    void send(const std::string& message);
+    void scheduleReconnect();
+};
+
+#endif // TRADE_STREAM_H
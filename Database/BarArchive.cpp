@@ -0,0 +1,588 @@
+#include "BarArchive.h"
+#include "CacheWriter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Records are written in native byte order, the marker makes a foreign archive fail loudly instead of reading garbage
+    constexpr char dataMagic[8] = { 'S', 'H', 'B', 'A', 'R', 'S', '0', '1' };
+    constexpr char indexMagic[8] = { 'S', 'H', 'B', 'I', 'D', 'X', '0', '1' };
+    constexpr std::uint32_t byteOrderMarker = 0x01020304;
+
+    // One record wide, so the records that follow stay 8-byte aligned inside the mapping
+    struct DataHeader {
+        char Magic[8];
+        std::uint32_t ByteOrder;
+        std::uint32_t RecordSize;
+        char Symbol[BarArchive::maxSymbolLength + 1];
+        std::uint64_t Reserved;
+    };
+
+    struct IndexHeader {
+        char Magic[8];
+        std::uint32_t ByteOrder;
+        std::uint32_t EntryCount;
+    };
+
+    struct IndexRecord {
+        char Symbol[BarArchive::maxSymbolLength + 1];
+        qint64 Count;
+        qint64 FirstTimestamp;
+        qint64 LastTimestamp;
+    };
+
+    static_assert(std::is_trivially_copyable_v<BarData> && std::is_standard_layout_v<BarData>, "BarData is stored as raw bytes");
+    static_assert(sizeof(BarData) == 48, "BarData must stay free of padding, it is the on-disk record");
+    static_assert(sizeof(DataHeader) == sizeof(BarData), "The data header must keep records aligned");
+
+    constexpr qint64 headerSize = sizeof(DataHeader);
+    constexpr qint64 recordSize = sizeof(BarData);
+
+    bool validHeader(const DataHeader& header) {
+        return std::memcmp(header.Magic, dataMagic, sizeof(dataMagic)) == 0 && header.ByteOrder == byteOrderMarker && header.RecordSize == recordSize;
+    }
+
+    std::string headerSymbol(const char* symbol) {
+        return std::string(symbol, strnlen(symbol, BarArchive::maxSymbolLength + 1));
+    }
+
+    // Maps the whole file read-only and drops the handle, the view stays valid until it is unmapped
+    bool mapFile(const QString& path, const std::byte*& data, std::size_t& length) {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(path).utf16()), GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size{};
+
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        if (!GetFileSizeEx(file, &size) || size.QuadPart < headerSize) {
+            CloseHandle(file);
+
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (mapping)
+            CloseHandle(mapping);
+
+        CloseHandle(file);
+
+        if (!view)
+            return false;
+
+        data = static_cast<const std::byte*>(view);
+        length = static_cast<std::size_t>(size.QuadPart);
+#else
+        int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+        struct stat info{};
+
+        if (fd < 0)
+            return false;
+
+        if (::fstat(fd, &info) != 0 || info.st_size < headerSize) {
+            ::close(fd);
+
+            return false;
+        }
+
+        void* view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+        ::close(fd);
+
+        if (view == MAP_FAILED)
+            return false;
+
+        data = static_cast<const std::byte*>(view);
+        length = static_cast<std::size_t>(info.st_size);
+#endif
+
+        return true;
+    }
+
+    void unmapFile(const std::byte* data, std::size_t length) {
+#ifdef _WIN32
+        Q_UNUSED(length);
+        UnmapViewOfFile(data);
+#else
+        ::munmap(const_cast<std::byte*>(data), length);
+#endif
+    }
+}
+
+BarArchive::BarArchive(const QString& directory) : directoryPath(directory) {}
+
+// Callers that need to know whether the index was written call close() themselves, here the result has nowhere to go
+BarArchive::~BarArchive() {
+    close();
+}
+
+bool BarArchive::open() {
+    if (!QDir().mkpath(directoryPath))
+        return fail("Failed to create archive directory " + directoryPath);
+
+    if (!readIndex())
+        return false;
+
+    // Appends after the last index write, or files the index does not know, are picked up from the data files
+    const QFileInfoList dataFiles = QDir(directoryPath).entryInfoList({ "*.bars" }, QDir::Files);
+    QHash<QString, qint64> expectedSizes;
+
+    for (const BarArchiveEntry& known : entryList)
+        expectedSizes.insert(QFileInfo(dataPath(known.Symbol)).fileName(), headerSize + known.Count * recordSize);
+
+    for (const QFileInfo& info : dataFiles) {
+        auto expected = expectedSizes.constFind(info.fileName());
+
+        if (expected != expectedSizes.constEnd() && info.size() == expected.value())
+            continue;
+
+        if (!scanDataFile(info.filePath()))
+            return false;
+    }
+
+    return true;
+}
+
+bool BarArchive::close() {
+    bool flushed = flush();
+
+    unmapAll();
+
+    return flushed;
+}
+
+bool BarArchive::flush() {
+    if (!indexDirty)
+        return true;
+
+    QSaveFile file(indexPath());
+    IndexHeader header{};
+
+    std::memcpy(header.Magic, indexMagic, sizeof(indexMagic));
+    header.ByteOrder = byteOrderMarker;
+    header.EntryCount = static_cast<std::uint32_t>(entryList.size());
+
+    if (!file.open(QIODevice::WriteOnly))
+        return fail("Failed to write archive index: " + file.errorString());
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const BarArchiveEntry& entry : entryList) {
+        IndexRecord record{};
+
+        std::memcpy(record.Symbol, entry.Symbol.data(), entry.Symbol.size());
+        record.Count = entry.Count;
+        record.FirstTimestamp = entry.FirstTimestamp;
+        record.LastTimestamp = entry.LastTimestamp;
+
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+
+    // The index is replaced in one rename, a crash leaves the previous one intact
+    if (!file.commit())
+        return fail("Failed to write archive index: " + file.errorString());
+
+    indexDirty = false;
+
+    return true;
+}
+
+bool BarArchive::append(const std::string& symbol, std::span<const BarData> bars) {
+    if (symbol.empty() || symbol.size() > maxSymbolLength)
+        return fail(QString("Symbol '%1' cannot be archived").arg(QString::fromStdString(symbol)));
+
+    const BarArchiveEntry* existing = entry(symbol);
+    auto first = bars.begin();
+
+    if (existing && existing->Count > 0) {
+        first = std::upper_bound(bars.begin(), bars.end(), existing->LastTimestamp, [](qint64 timestamp, const BarData& bar) {
+            return timestamp < bar.Timestamp;
+        });
+    }
+
+    if (first == bars.end())
+        return true;
+
+    for (auto bar = first + 1; bar != bars.end(); ++bar) {
+        if (bar->Timestamp <= (bar - 1)->Timestamp)
+            return fail(QString("Bars for %1 are not in ascending time order").arg(QString::fromStdString(symbol)));
+    }
+
+    // The mapping would not cover the new records, it is rebuilt on the next read
+    unmap(symbol);
+
+    QFile file(dataPath(symbol));
+    qint64 count = bars.end() - first;
+    DataHeader header{};
+
+    if (!file.open(QIODevice::ReadWrite))
+        return fail("Failed to open " + file.fileName() + ": " + file.errorString());
+
+    // A new file, or one whose header write was interrupted, gets a header. An existing one has to be this symbol's
+    // before anything behind its header is truncated.
+    if (file.size() < headerSize) {
+        std::memcpy(header.Magic, dataMagic, sizeof(dataMagic));
+        header.ByteOrder = byteOrderMarker;
+        header.RecordSize = recordSize;
+        std::memcpy(header.Symbol, symbol.data(), symbol.size());
+
+        if (!file.resize(0) || file.write(reinterpret_cast<const char*>(&header), headerSize) != headerSize)
+            return fail("Failed to write " + file.fileName() + ": " + file.errorString());
+    } else if (file.read(reinterpret_cast<char*>(&header), headerSize) != headerSize || !validHeader(header) ||
+               headerSymbol(header.Symbol) != symbol) {
+        return fail(file.fileName() + " does not hold the bars of " + QString::fromStdString(symbol));
+    }
+
+    BarArchiveEntry& target = entryFor(symbol);
+
+    // A torn record from an interrupted append is dropped before writing behind it
+    if (!file.seek(headerSize + target.Count * recordSize) || !file.resize(headerSize + target.Count * recordSize))
+        return fail("Failed to seek in " + file.fileName() + ": " + file.errorString());
+
+    if (file.write(reinterpret_cast<const char*>(&*first), count * recordSize) != count * recordSize)
+        return fail("Failed to write " + file.fileName() + ": " + file.errorString());
+
+    if (target.Count == 0)
+        target.FirstTimestamp = first->Timestamp;
+
+    target.Count += count;
+    target.LastTimestamp = bars.back().Timestamp;
+    indexDirty = true;
+    written += count;
+
+    return true;
+}
+
+const std::vector<BarArchiveEntry>& BarArchive::entries() const {
+    return entryList;
+}
+
+const BarArchiveEntry* BarArchive::entry(const std::string& symbol) const {
+    auto found = entryIndex.find(symbol);
+
+    return found == entryIndex.end() ? nullptr : &entryList[found->second];
+}
+
+std::span<const BarData> BarArchive::bars(const std::string& symbol) {
+    const Mapping* mapping = map(symbol);
+
+    if (!mapping)
+        return {};
+
+    const qint64 count = std::min<qint64>((static_cast<qint64>(mapping->Length) - headerSize) / recordSize, entry(symbol)->Count);
+
+    return std::span<const BarData>(reinterpret_cast<const BarData*>(mapping->Data + headerSize), static_cast<std::size_t>(count));
+}
+
+std::span<const BarData> BarArchive::bars(const std::string& symbol, qint64 since, qint64 until) {
+    std::span<const BarData> all = bars(symbol);
+
+    auto first = std::lower_bound(all.begin(), all.end(), since, [](const BarData& bar, qint64 timestamp) {
+        return bar.Timestamp < timestamp;
+    });
+    auto last = std::upper_bound(first, all.end(), until, [](qint64 timestamp, const BarData& bar) {
+        return timestamp < bar.Timestamp;
+    });
+
+    return std::span<const BarData>(first, last);
+}
+
+bool BarArchive::loadInto(PriceStore& store, qint64 since, qint64 until) {
+    std::vector<const BarArchiveEntry*> ordered;
+    std::size_t barCapacity = 0;
+
+    for (const BarArchiveEntry& candidate : entryList) {
+        if (candidate.Count > 0 && candidate.LastTimestamp >= since && candidate.FirstTimestamp <= until) {
+            ordered.push_back(&candidate);
+            barCapacity += static_cast<std::size_t>(candidate.Count);
+        }
+    }
+
+    // Same symbol order as PriceStore::load, so results line up with a load from the cache
+    std::sort(ordered.begin(), ordered.end(), [](const BarArchiveEntry* a, const BarArchiveEntry* b) {
+        return a->Symbol < b->Symbol;
+    });
+
+    store.clear();
+    store.reserve(ordered.size(), barCapacity);
+
+    for (const BarArchiveEntry* candidate : ordered) {
+        if (!map(candidate->Symbol))
+            return false;
+
+        std::span<const BarData> window = bars(candidate->Symbol, since, until);
+
+        if (!window.empty())
+            store.append(candidate->Symbol, window);
+    }
+
+    return true;
+}
+
+bool BarArchive::importFrom(QSqlDatabase& db, qint64 since, qint64 until) {
+    QSqlQuery historyQuery(db);
+    std::vector<BarData> pending;
+    std::string currentSymbol;
+
+    // Clustered on (symbol, timestamp), so each symbol arrives as one ascending run
+    historyQuery.setForwardOnly(true);
+    historyQuery.prepare("SELECT symbol, timestamp, open, high, low, close, volume FROM historical_data "
+                         "WHERE timestamp >= :since AND timestamp <= :until ORDER BY symbol, timestamp");
+    historyQuery.bindValue(":since", since);
+    historyQuery.bindValue(":until", until);
+
+    if (!historyQuery.exec())
+        return fail("Query execution failed:" + historyQuery.lastError().text());
+
+    while (historyQuery.next()) {
+        std::string rowSymbol = historyQuery.value(0).toString().toStdString();
+
+        if (rowSymbol != currentSymbol) {
+            if (!pending.empty() && !append(currentSymbol, pending))
+                return false;
+
+            pending.clear();
+            currentSymbol = std::move(rowSymbol);
+        }
+
+        pending.push_back({ historyQuery.value(1).toLongLong(),
+                            historyQuery.value(2).toDouble(),
+                            historyQuery.value(3).toDouble(),
+                            historyQuery.value(4).toDouble(),
+                            historyQuery.value(5).toDouble(),
+                            historyQuery.value(6).toLongLong() });
+    }
+
+    if (!pending.empty() && !append(currentSymbol, pending))
+        return false;
+
+    return flush();
+}
+
+bool BarArchive::exportTo(QSqlDatabase& db, qint64 since, qint64 until) {
+    CacheWriter writer(db);
+
+    if (!writer.prepare())
+        return fail(writer.lastError());
+
+    for (const BarArchiveEntry& source : entryList) {
+        if (source.Count == 0 || source.LastTimestamp < since || source.FirstTimestamp > until)
+            continue;
+
+        if (!map(source.Symbol)) {
+            writer.rollback();
+
+            return false;
+        }
+
+        // The mapped records are bound directly, nothing is copied into an intermediate vector
+        std::span<const BarData> window = bars(source.Symbol, since, until);
+
+        if (!writer.nextSymbol() || !writer.writeBars(source.Symbol, window)) {
+            writer.rollback();
+
+            return fail(writer.lastError());
+        }
+    }
+
+    if (!writer.commit())
+        return fail(writer.lastError());
+
+    written += writer.rowsWritten();
+
+    return true;
+}
+
+const QString& BarArchive::lastError() const {
+    return errorMessage;
+}
+
+qint64 BarArchive::barsWritten() const {
+    return written;
+}
+
+QString BarArchive::dataPath(const std::string& symbol) const {
+    static constexpr char hexDigits[] = "0123456789ABCDEF";
+    std::string fileName;
+
+    // Every byte but upper case letters, digits, '.' and '-' is percent-escaped. BRK/B can then not name a subdirectory,
+    // and the name stays reversible, so BRK/B, BRK_B and brk_b get files of their own even on case-insensitive file
+    // systems.
+    for (unsigned char character : symbol) {
+        if ((character >= 'A' && character <= 'Z') || (character >= '0' && character <= '9') || character == '.' || character == '-') {
+            fileName += static_cast<char>(character);
+        } else {
+            fileName += '%';
+            fileName += hexDigits[character >> 4];
+            fileName += hexDigits[character & 0x0F];
+        }
+    }
+
+    return QDir(directoryPath).filePath(QString::fromStdString(fileName) + ".bars");
+}
+
+QString BarArchive::indexPath() const {
+    return QDir(directoryPath).filePath("archive.idx");
+}
+
+bool BarArchive::readIndex() {
+    QFile file(indexPath());
+    IndexHeader header{};
+
+    if (!file.exists())
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly))
+        return fail("Failed to read archive index: " + file.errorString());
+
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) ||
+        std::memcmp(header.Magic, indexMagic, sizeof(indexMagic)) != 0 || header.ByteOrder != byteOrderMarker)
+        return fail(file.fileName() + " is not a bar archive index for this platform");
+
+    for (std::uint32_t i = 0; i < header.EntryCount; ++i) {
+        IndexRecord record{};
+
+        if (file.read(reinterpret_cast<char*>(&record), sizeof(record)) != sizeof(record))
+            return fail(file.fileName() + " is truncated");
+
+        BarArchiveEntry& loaded = entryFor(headerSymbol(record.Symbol));
+
+        loaded.Count = record.Count;
+        loaded.FirstTimestamp = record.FirstTimestamp;
+        loaded.LastTimestamp = record.LastTimestamp;
+    }
+
+    return true;
+}
+
+bool BarArchive::scanDataFile(const QString& path) {
+    QFile file(path);
+    DataHeader header{};
+
+    if (!file.open(QIODevice::ReadOnly))
+        return fail("Failed to open " + path + ": " + file.errorString());
+
+    if (file.read(reinterpret_cast<char*>(&header), headerSize) != headerSize || !validHeader(header))
+        return fail(path + " is not a bar archive file for this platform");
+
+    const std::string symbol = headerSymbol(header.Symbol);
+    const qint64 count = (file.size() - headerSize) / recordSize;
+    const QString expectedPath = dataPath(symbol);
+    BarData first{};
+    BarData last{};
+
+    if (count > 0) {
+        file.seek(headerSize);
+        file.read(reinterpret_cast<char*>(&first), recordSize);
+
+        file.seek(headerSize + (count - 1) * recordSize);
+        file.read(reinterpret_cast<char*>(&last), recordSize);
+    }
+
+    file.close();
+
+    // Archives from before names were escaped replaced those characters with '_', their files move to the escaped name
+    if (QFileInfo(path).fileName() != QFileInfo(expectedPath).fileName()) {
+        if (QFile::exists(expectedPath))
+            return fail(path + " and " + expectedPath + " both hold the bars of " + QString::fromStdString(symbol));
+
+        if (!QFile::rename(path, expectedPath))
+            return fail("Failed to rename " + path + " to " + expectedPath);
+    }
+
+    BarArchiveEntry& scanned = entryFor(symbol);
+
+    scanned.Count = count;
+    scanned.FirstTimestamp = count > 0 ? first.Timestamp : 0;
+    scanned.LastTimestamp = count > 0 ? last.Timestamp : 0;
+
+    unmap(symbol);
+    indexDirty = true;
+
+    return true;
+}
+
+BarArchiveEntry& BarArchive::entryFor(const std::string& symbol) {
+    auto [position, inserted] = entryIndex.try_emplace(symbol, entryList.size());
+
+    if (inserted)
+        entryList.push_back({ symbol, 0, 0, 0 });
+
+    return entryList[position->second];
+}
+
+const BarArchive::Mapping* BarArchive::map(const std::string& symbol) {
+    auto found = mappings.find(symbol);
+
+    if (found != mappings.end())
+        return &found->second;
+
+    const BarArchiveEntry* source = entry(symbol);
+
+    if (!source || source->Count == 0)
+        return nullptr;
+
+    Mapping mapping;
+
+    if (!mapFile(dataPath(symbol), mapping.Data, mapping.Length)) {
+        fail("Failed to map " + dataPath(symbol));
+
+        return nullptr;
+    }
+
+    const DataHeader* header = reinterpret_cast<const DataHeader*>(mapping.Data);
+
+    if (!validHeader(*header) || headerSymbol(header->Symbol) != symbol) {
+        unmapFile(mapping.Data, mapping.Length);
+        fail(dataPath(symbol) + " does not hold the bars of " + QString::fromStdString(symbol));
+
+        return nullptr;
+    }
+
+    return &mappings.emplace(symbol, mapping).first->second;
+}
+
+void BarArchive::unmap(const std::string& symbol) {
+    auto found = mappings.find(symbol);
+
+    if (found == mappings.end())
+        return;
+
+    unmapFile(found->second.Data, found->second.Length);
+    mappings.erase(found);
+}
+
+void BarArchive::unmapAll() {
+    for (const auto& [symbol, mapping] : mappings)
+        unmapFile(mapping.Data, mapping.Length);
+
+    mappings.clear();
+}
+
+bool BarArchive::fail(const QString& message) {
+    errorMessage = message;
+
+    return false;
+}
@@ -0,0 +1,98 @@
+#ifndef BAR_ARCHIVE_H
+#define BAR_ARCHIVE_H
+
+#include "Analysis/PriceStore.h"
+#include "Core/MarketData.h"
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QtGlobal>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct BarArchiveEntry {
+    std::string Symbol;
+    qint64 Count = 0;
+    qint64 FirstTimestamp = 0;
+    qint64 LastTimestamp = 0;
+};
+
+// Append-only binary bar store for long histories. Every symbol has one file of fixed-width BarData records, oldest
+// first, that is memory-mapped on first use, so reads hand out spans straight into the page cache. An index file keeps
+// the counts and time ranges so listing an archive does not touch the data files. One archive holds one bar timeframe.
+class BarArchive {
+public:
+    static constexpr std::size_t maxSymbolLength = 23;
+
+    explicit BarArchive(const QString& directory);
+    ~BarArchive();
+
+    BarArchive(const BarArchive&) = delete;
+    BarArchive& operator=(const BarArchive&) = delete;
+
+    // Creates the directory if needed and reads the index, data files newer than the index are re-scanned
+    bool open();
+
+    // Writes the index and unmaps every data file, spans handed out before are invalid afterwards
+    bool close();
+
+    // Writes the index, appends are durable without it but listing them needs a re-scan on the next open
+    bool flush();
+
+    // Bars must be oldest first, those not newer than the symbol's last archived bar are skipped.
+    // Invalidates spans of that symbol.
+    bool append(const std::string& symbol, std::span<const BarData> bars);
+
+    const std::vector<BarArchiveEntry>& entries() const;
+    const BarArchiveEntry* entry(const std::string& symbol) const;
+
+    // Zero-copy views, valid until the symbol is appended to or the archive is closed
+    std::span<const BarData> bars(const std::string& symbol);
+    std::span<const BarData> bars(const std::string& symbol, qint64 since, qint64 until);
+
+    // Copies every symbol's bars in [since, until] into the structure-of-arrays store the kernels read
+    bool loadInto(PriceStore& store, qint64 since = 0, qint64 until = std::numeric_limits<qint64>::max());
+
+    // Appends historical_data rows in [since, until], one sequential read clustered by symbol
+    bool importFrom(QSqlDatabase& db, qint64 since = 0, qint64 until = std::numeric_limits<qint64>::max());
+
+    // Writes archived bars in [since, until] into historical_data, replacing rows with the same key
+    bool exportTo(QSqlDatabase& db, qint64 since = 0, qint64 until = std::numeric_limits<qint64>::max());
+
+    const QString& lastError() const;
+    qint64 barsWritten() const;
+
+private:
+    struct Mapping {
+        const std::byte* Data = nullptr;
+        std::size_t Length = 0;
+    };
+
+    QString directoryPath;
+    std::vector<BarArchiveEntry> entryList;
+    std::unordered_map<std::string, std::size_t> entryIndex;
+    std::unordered_map<std::string, Mapping> mappings;
+    bool indexDirty = false;
+    QString errorMessage;
+    qint64 written = 0;
+
+    QString dataPath(const std::string& symbol) const;
+    QString indexPath() const;
+
+    bool readIndex();
+    bool scanDataFile(const QString& path);
+    BarArchiveEntry& entryFor(const std::string& symbol);
+
+    const Mapping* map(const std::string& symbol);
+    void unmap(const std::string& symbol);
+    void unmapAll();
+
+    bool fail(const QString& message);
+};
+
+#endif // BAR_ARCHIVE_H
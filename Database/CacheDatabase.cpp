@@ -0,0 +1,52 @@
+#include "CacheDatabase.h"
+#include "SchemaMigrations.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSqlQuery>
+#include <QSqlError>
+
+bool CacheDatabase::open(QSqlDatabase& db, const QString& filePath, const QString& connectionName, QString& errorMessage,
+                         QStringList* migrationsApplied) {
+    db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(filePath);
+
+    if (!db.open()) {
+        errorMessage = "Failed to open SQLite database: " + filePath;
+
+        return false;
+    }
+
+    return configure(db, errorMessage) && SchemaMigrations::migrate(db, errorMessage, migrationsApplied);
+}
+
+bool CacheDatabase::configure(QSqlDatabase& db, QString& errorMessage) {
+    // WAL lets the GUI read while a scan writes and turns per-commit fsyncs into sequential log appends.
+    // With WAL, synchronous=NORMAL only syncs at checkpoints and stays safe against corruption.
+    const char* pragmas[] = {
+        "PRAGMA journal_mode = WAL",
+        "PRAGMA synchronous = NORMAL",
+        "PRAGMA cache_size = -65536",   // 64 MiB page cache
+        "PRAGMA temp_store = MEMORY",
+        "PRAGMA busy_timeout = 5000"    // Wait for the other connection instead of failing with SQLITE_BUSY
+    };
+
+    for (const char* pragma : pragmas) {
+        QSqlQuery pragmaQuery(db);
+
+        if (!pragmaQuery.exec(pragma)) {
+            errorMessage = "Failed to configure database (" + QString(pragma) + "): " + pragmaQuery.lastError().text();
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString CacheDatabase::defaultPath() {
+    // Set up SQLite database in the same folder as the executable
+    QDir dir(QCoreApplication::applicationDirPath());
+
+    return dir.filePath("cache.db");
+}
@@ -0,0 +1,22 @@
+#ifndef CACHE_DATABASE_H
+#define CACHE_DATABASE_H
+
+#include <QString>
+#include <QStringList>
+#include <QSqlDatabase>
+
+class CacheDatabase {
+public:
+    // Opens (or creates) the SQLite cache at filePath under the given connection name and migrates it to the current schema,
+    // migrationsApplied collects a line per migration step if given
+    static bool open(QSqlDatabase& db, const QString& filePath, const QString& connectionName, QString& errorMessage,
+                     QStringList* migrationsApplied = nullptr);
+
+    // Path of cache.db next to the running executable
+    static QString defaultPath();
+
+private:
+    static bool configure(QSqlDatabase& db, QString& errorMessage);
+};
+
+#endif // CACHE_DATABASE_H
@@ -0,0 +1,272 @@
+#include "CacheWriter.h"
+
+#include <QSqlError>
+#include <QVariant>
+#include <QVariantList>
+
+CacheWriter::CacheWriter(QSqlDatabase& database)
+    : db(database),
+      stocksInsertQuery(database),
+      tradesInsertQuery(database),
+      historicalDataInsertQuery(database),
+      historicalDataDeleteQuery(database),
+      scoresInsertQuery(database),
+      indicatorStateInsertQuery(database),
+      markExcludedQuery(database),
+      excludeScoresQuery(database),
+      rollups(database) {}
+
+// Anything not committed explicitly is thrown away, e.g. when a scan aborts halfway through a batch
+CacheWriter::~CacheWriter() {
+    rollback();
+}
+
+const QString& CacheWriter::lastError() const {
+    return errorMessage;
+}
+
+qint64 CacheWriter::rowsWritten() const {
+    return rows + rollups.rowsWritten();
+}
+
+bool CacheWriter::fail(const QSqlQuery& query) {
+    errorMessage = "Query execution failed:" + query.lastError().text();
+
+    return false;
+}
+
+bool CacheWriter::prepare() {
+    if (!stocksInsertQuery.prepare("INSERT OR REPLACE INTO stocks (id, name, symbol, last_updated) VALUES (:id, :name, :symbol, :lastUpdated)"))
+        return fail(stocksInsertQuery);
+
+    if (!tradesInsertQuery.prepare("INSERT OR REPLACE INTO trades (symbol, price, size) VALUES (:symbol, :price, :size)"))
+        return fail(tradesInsertQuery);
+
+    if (!historicalDataInsertQuery.prepare("INSERT OR REPLACE INTO historical_data (symbol, timestamp, open, high, low, close, volume) "
+                                           "VALUES (?, ?, ?, ?, ?, ?, ?)"))
+        return fail(historicalDataInsertQuery);
+
+    if (!historicalDataDeleteQuery.prepare("DELETE FROM historical_data WHERE symbol = :symbol"))
+        return fail(historicalDataDeleteQuery);
+
+    if (!scoresInsertQuery.prepare("INSERT OR REPLACE INTO scores (symbol, ma_score, rsi_score, bb_score, total_score) "
+                                   "VALUES (:symbol, :ma_score, :rsi_score, :bb_score, :total_score)"))
+        return fail(scoresInsertQuery);
+
+    if (!indicatorStateInsertQuery.prepare("INSERT OR REPLACE INTO indicator_state "
+                                           "(symbol, last_timestamp, count, shift, sum, sum_squares, gain_sum, loss_sum, down_moves, last_close) "
+                                           "VALUES (:symbol, :last_timestamp, :count, :shift, :sum, :sum_squares, :gain_sum, :loss_sum, :down_moves, :last_close)"))
+        return fail(indicatorStateInsertQuery);
+
+    if (!markExcludedQuery.prepare("UPDATE stocks SET excluded = 1 WHERE symbol = :symbol"))
+        return fail(markExcludedQuery);
+
+    if (!excludeScoresQuery.prepare("UPDATE stocks SET excluded = 1 WHERE excluded = 0 AND symbol IN "
+                                    "(SELECT symbol FROM scores WHERE total_score >= :ceiling)"))
+        return fail(excludeScoresQuery);
+
+    if (!rollups.prepare()) {
+        errorMessage = rollups.lastError();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool CacheWriter::begin() {
+    if (inTransaction)
+        return true;
+
+    if (!db.transaction()) {
+        errorMessage = "Failed to start transaction: " + db.lastError().text();
+
+        return false;
+    }
+
+    inTransaction = true;
+    symbolsInTransaction = 0;
+
+    return true;
+}
+
+bool CacheWriter::commit() {
+    if (!inTransaction)
+        return true;
+
+    inTransaction = false;
+
+    // Every symbol written in the batch is rolled up at once, inside the transaction it was written in
+    if (!rollups.flush()) {
+        errorMessage = rollups.lastError();
+        rollups.discard();
+        db.rollback();
+
+        return false;
+    }
+
+    if (!db.commit()) {
+        errorMessage = "Failed to commit transaction: " + db.lastError().text();
+        db.rollback();
+
+        return false;
+    }
+
+    return true;
+}
+
+void CacheWriter::rollback() {
+    if (!inTransaction)
+        return;
+
+    inTransaction = false;
+    rollups.discard();
+    db.rollback();
+}
+
+bool CacheWriter::nextSymbol() {
+    if (!inTransaction)
+        return begin();
+
+    if (++symbolsInTransaction < symbolsPerTransaction)
+        return true;
+
+    return commit() && begin();
+}
+
+bool CacheWriter::writeStock(const std::string& id, const std::string& name, const std::string& symbol, qint64 lastUpdated) {
+    stocksInsertQuery.bindValue(":id", QString::fromStdString(id));
+    stocksInsertQuery.bindValue(":name", QString::fromStdString(name));
+    stocksInsertQuery.bindValue(":symbol", QString::fromStdString(symbol));
+    stocksInsertQuery.bindValue(":lastUpdated", lastUpdated);
+
+    if (!stocksInsertQuery.exec())
+        return fail(stocksInsertQuery);
+
+    ++rows;
+
+    return true;
+}
+
+bool CacheWriter::writeTrade(const std::string& symbol, double price, qint64 size) {
+    tradesInsertQuery.bindValue(":symbol", QString::fromStdString(symbol));
+    tradesInsertQuery.bindValue(":price", price);
+    tradesInsertQuery.bindValue(":size", size);
+
+    if (!tradesInsertQuery.exec())
+        return fail(tradesInsertQuery);
+
+    ++rows;
+
+    return true;
+}
+
+bool CacheWriter::writeBars(const std::string& symbol, std::span<const BarData> bars) {
+    if (bars.empty())
+        return true;
+
+    // Column-wise bindings let the driver step the same statement once per bar
+    QVariantList symbols, timestamps, opens, highs, lows, closes, volumes;
+    QString symbolText = QString::fromStdString(symbol);
+
+    for (const BarData& bar : bars) {
+        symbols << symbolText;
+        timestamps << bar.Timestamp;
+        opens << bar.Open;
+        highs << bar.High;
+        lows << bar.Low;
+        closes << bar.Close;
+        volumes << bar.Volume;
+    }
+
+    historicalDataInsertQuery.addBindValue(symbols);
+    historicalDataInsertQuery.addBindValue(timestamps);
+    historicalDataInsertQuery.addBindValue(opens);
+    historicalDataInsertQuery.addBindValue(highs);
+    historicalDataInsertQuery.addBindValue(lows);
+    historicalDataInsertQuery.addBindValue(closes);
+    historicalDataInsertQuery.addBindValue(volumes);
+
+    if (!historicalDataInsertQuery.execBatch())
+        return fail(historicalDataInsertQuery);
+
+    rows += static_cast<qint64>(bars.size());
+    rollups.apply(symbol, bars);
+
+    return true;
+}
+
+bool CacheWriter::deleteBars(const std::string& symbol) {
+    historicalDataDeleteQuery.bindValue(":symbol", QString::fromStdString(symbol));
+
+    if (!historicalDataDeleteQuery.exec())
+        return fail(historicalDataDeleteQuery);
+
+    rows += historicalDataDeleteQuery.numRowsAffected();
+
+    if (!rollups.invalidate(symbol)) {
+        errorMessage = rollups.lastError();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool CacheWriter::writeScores(const std::string& symbol, double maScore, double rsiScore, double bbScore, double totalScore) {
+    scoresInsertQuery.bindValue(":symbol", QString::fromStdString(symbol));
+    scoresInsertQuery.bindValue(":ma_score", maScore);
+    scoresInsertQuery.bindValue(":rsi_score", rsiScore);
+    scoresInsertQuery.bindValue(":bb_score", bbScore);
+    scoresInsertQuery.bindValue(":total_score", totalScore);
+
+    if (!scoresInsertQuery.exec())
+        return fail(scoresInsertQuery);
+
+    ++rows;
+
+    return true;
+}
+
+bool CacheWriter::writeIndicatorState(const std::string& symbol, const IndicatorState& state) {
+    indicatorStateInsertQuery.bindValue(":symbol", QString::fromStdString(symbol));
+    indicatorStateInsertQuery.bindValue(":last_timestamp", state.LastTimestamp);
+    indicatorStateInsertQuery.bindValue(":count", state.Count);
+    indicatorStateInsertQuery.bindValue(":shift", state.Shift);
+    indicatorStateInsertQuery.bindValue(":sum", state.Sum);
+    indicatorStateInsertQuery.bindValue(":sum_squares", state.SumSquares);
+    indicatorStateInsertQuery.bindValue(":gain_sum", state.GainSum);
+    indicatorStateInsertQuery.bindValue(":loss_sum", state.LossSum);
+    indicatorStateInsertQuery.bindValue(":down_moves", state.DownMoves);
+    indicatorStateInsertQuery.bindValue(":last_close", state.LastClose);
+
+    if (!indicatorStateInsertQuery.exec())
+        return fail(indicatorStateInsertQuery);
+
+    ++rows;
+
+    return true;
+}
+
+bool CacheWriter::markExcluded(const std::string& symbol) {
+    markExcludedQuery.bindValue(":symbol", QString::fromStdString(symbol));
+
+    if (!markExcludedQuery.exec())
+        return fail(markExcludedQuery);
+
+    // No row changes if the symbol is not cached
+    rows += markExcludedQuery.numRowsAffected();
+
+    return true;
+}
+
+bool CacheWriter::excludeScoresAtOrAbove(double scoreCeiling) {
+    excludeScoresQuery.bindValue(":ceiling", scoreCeiling);
+
+    if (!excludeScoresQuery.exec())
+        return fail(excludeScoresQuery);
+
+    rows += excludeScoresQuery.numRowsAffected();
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef CACHE_WRITER_H
+#define CACHE_WRITER_H
+
+#include "Analysis/IndicatorState.h"
+#include "Core/MarketData.h"
+#include "RollupCache.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <span>
+#include <string>
+#include <vector>
+
+// Writes scan results into the cache with statements prepared once per scan and many symbols per transaction. Weekly
+// and monthly rollups of every symbol whose bars were written are refreshed together when the transaction commits.
+class CacheWriter {
+public:
+    // Symbols grouped into one transaction, a single fsync covers the whole batch
+    static constexpr int symbolsPerTransaction = 500;
+
+    explicit CacheWriter(QSqlDatabase& database);
+    ~CacheWriter();
+
+    // Prepares every statement, must succeed before anything is written
+    bool prepare();
+
+    bool begin();
+    bool commit();
+    void rollback();
+
+    // Call before writing each symbol, opens a transaction or rolls over to a new one every symbolsPerTransaction symbols
+    bool nextSymbol();
+
+    bool writeStock(const std::string& id, const std::string& name, const std::string& symbol, qint64 lastUpdated);
+    bool writeTrade(const std::string& symbol, double price, qint64 size);
+    bool writeBars(const std::string& symbol, std::span<const BarData> bars);
+    bool deleteBars(const std::string& symbol);
+    bool writeScores(const std::string& symbol, double maScore, double rsiScore, double bbScore, double totalScore);
+    bool writeIndicatorState(const std::string& symbol, const IndicatorState& state);
+    bool markExcluded(const std::string& symbol);
+
+    // Set-based sweep over the whole scores table, catches rows left behind by earlier scans
+    bool excludeScoresAtOrAbove(double scoreCeiling);
+
+    const QString& lastError() const;
+    qint64 rowsWritten() const;
+
+private:
+    QSqlDatabase& db;
+
+    QSqlQuery stocksInsertQuery;
+    QSqlQuery tradesInsertQuery;
+    QSqlQuery historicalDataInsertQuery;
+    QSqlQuery historicalDataDeleteQuery;
+    QSqlQuery scoresInsertQuery;
+    QSqlQuery indicatorStateInsertQuery;
+    QSqlQuery markExcludedQuery;
+    QSqlQuery excludeScoresQuery;
+    RollupCache rollups;
+
+    QString errorMessage;
+    bool inTransaction = false;
+    int symbolsInTransaction = 0;
+    qint64 rows = 0;
+
+    bool fail(const QSqlQuery& query);
+};
+
+#endif // CACHE_WRITER_H
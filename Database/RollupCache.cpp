@@ -0,0 +1,356 @@
+#include "RollupCache.h"
+
+#include <QSqlError>
+#include <QVariant>
+#include <QVariantList>
+#include <algorithm>
+#include <limits>
+
+namespace {
+    constexpr qint64 everything = std::numeric_limits<qint64>::min();
+}
+
+bool RollupCache::isCached(Timeframe timeframe) {
+    return std::find(cachedTimeframes.begin(), cachedTimeframes.end(), timeframe) != cachedTimeframes.end();
+}
+
+RollupCache::RollupCache(QSqlDatabase& database)
+    : db(database),
+      queueQuery(database),
+      stateQuery(database),
+      barsQuery(database),
+      clearQuery(database),
+      upsertQuery(database),
+      deleteQuery(database) {}
+
+const QString& RollupCache::lastError() const {
+    return errorMessage;
+}
+
+qint64 RollupCache::rowsWritten() const {
+    return rows;
+}
+
+bool RollupCache::fail(const QSqlQuery& query) {
+    errorMessage = "Query execution failed:" + query.lastError().text();
+
+    return false;
+}
+
+bool RollupCache::prepare() {
+    QSqlQuery createQuery(db);
+
+    // The symbols of one flush and the range of their bars to read back, private to the connection
+    if (!createQuery.exec("CREATE TEMP TABLE IF NOT EXISTS rollup_queue ("
+                          "symbol TEXT PRIMARY KEY, oldest INTEGER NOT NULL, since INTEGER NOT NULL, until INTEGER NOT NULL) WITHOUT ROWID"))
+        return fail(createQuery);
+
+    if (!queueQuery.prepare("INSERT OR REPLACE INTO temp.rollup_queue (symbol, oldest, since, until) VALUES (?, ?, ?, ?)"))
+        return fail(queueQuery);
+
+    // Per queued symbol the bars stored from its oldest written one on, and one descent of the primary key per
+    // timeframe for the newest bucket, however many buckets the symbol has
+    QString state = "SELECT q.symbol, (SELECT COUNT(*) FROM historical_data WHERE symbol = q.symbol AND timestamp >= q.oldest)";
+
+    for (Timeframe timeframe : cachedTimeframes)
+        state += QString(", (SELECT MAX(timestamp) FROM bar_rollups WHERE symbol = q.symbol AND timeframe = '%1')").arg(BarAggregator::timeframeName(timeframe));
+
+    stateQuery.setForwardOnly(true);
+
+    if (!stateQuery.prepare(state + " FROM temp.rollup_queue AS q"))
+        return fail(stateQuery);
+
+    // The queue drives the join, so every symbol's bars are one range of the primary key and arrive in order unsorted
+    barsQuery.setForwardOnly(true);
+
+    if (!barsQuery.prepare("SELECT q.symbol, h.timestamp, h.open, h.high, h.low, h.close, h.volume FROM temp.rollup_queue AS q "
+                           "CROSS JOIN historical_data AS h ON h.symbol = q.symbol AND h.timestamp >= q.since AND h.timestamp < q.until "
+                           "ORDER BY q.symbol, h.timestamp"))
+        return fail(barsQuery);
+
+    if (!clearQuery.prepare("DELETE FROM temp.rollup_queue"))
+        return fail(clearQuery);
+
+    if (!upsertQuery.prepare("INSERT OR REPLACE INTO bar_rollups "
+                             "(symbol, timeframe, timestamp, open, high, low, close, volume, bar_count, last_timestamp) "
+                             "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"))
+        return fail(upsertQuery);
+
+    if (!deleteQuery.prepare("DELETE FROM bar_rollups WHERE symbol = :symbol"))
+        return fail(deleteQuery);
+
+    return true;
+}
+
+void RollupCache::apply(const std::string& symbol, std::span<const BarData> bars) {
+    if (bars.empty())
+        return;
+
+    qint64 oldest = std::min_element(bars.begin(), bars.end(), [](const BarData& a, const BarData& b) {
+        return a.Timestamp < b.Timestamp;
+    })->Timestamp;
+
+    auto [position, inserted] = queued.try_emplace(symbol);
+    Queued& entry = position->second;
+
+    entry.oldest = inserted ? oldest : std::min(entry.oldest, oldest);
+
+    if (!entry.held)
+        return;
+
+    if (held + bars.size() <= heldBars) {
+        entry.written.insert(entry.written.end(), bars.begin(), bars.end());
+        held += bars.size();
+
+        return;
+    }
+
+    // Past the budget the symbol's bars are read back like any stored ones
+    held -= entry.written.size();
+    entry.written = std::vector<BarData>();
+    entry.held = false;
+}
+
+void RollupCache::discard() {
+    queued.clear();
+    held = 0;
+}
+
+bool RollupCache::writeQueue() {
+    QVariantList queuedSymbols, oldest, since, until;
+
+    for (const auto& [symbol, entry] : queued) {
+        queuedSymbols << QString::fromStdString(symbol);
+        oldest << entry.oldest;
+        since << *std::min_element(entry.since.begin(), entry.since.end());
+        until << entry.until;
+    }
+
+    queueQuery.addBindValue(queuedSymbols);
+    queueQuery.addBindValue(oldest);
+    queueQuery.addBindValue(since);
+    queueQuery.addBindValue(until);
+
+    if (!queueQuery.execBatch())
+        return fail(queueQuery);
+
+    return true;
+}
+
+bool RollupCache::flush() {
+    if (queued.empty())
+        return true;
+
+    for (auto& [symbol, entry] : queued) {
+        // Oldest first with one bar per timestamp, the last of duplicates is the one the insert kept
+        std::stable_sort(entry.written.begin(), entry.written.end(), [](const BarData& a, const BarData& b) {
+            return a.Timestamp < b.Timestamp;
+        });
+
+        std::size_t unique = 0;
+
+        for (const BarData& bar : entry.written) {
+            if (unique > 0 && entry.written[unique - 1].Timestamp == bar.Timestamp)
+                entry.written[unique - 1] = bar;
+            else
+                entry.written[unique++] = bar;
+        }
+
+        entry.written.resize(unique);
+
+        // A symbol without stored rollups of a timeframe is rolled up from its first bar
+        entry.since.fill(everything);
+        entry.until = std::numeric_limits<qint64>::max();
+    }
+
+    if (!clearQuery.exec())
+        return fail(clearQuery);
+
+    if (!writeQueue())
+        return false;
+
+    if (!stateQuery.exec())
+        return fail(stateQuery);
+
+    while (stateQuery.next()) {
+        Queued& entry = queued[stateQuery.value(0).toString().toStdString()];
+
+        for (std::size_t i = 0; i < cachedTimeframes.size(); ++i) {
+            QVariant newest = stateQuery.value(static_cast<int>(i) + 2);
+
+            // The newest bucket is the only one still open, unless the new bars reach further back than that
+            if (!newest.isNull())
+                entry.since[i] = std::min(newest.toLongLong(), BarAggregator::bucketStart(cachedTimeframes[i], entry.oldest));
+        }
+
+        // When nothing else is stored from the oldest written bar on, which is the usual case, those bars are taken
+        // from memory and only the older part of the open buckets is read back
+        if (entry.held && stateQuery.value(1).toLongLong() == static_cast<qint64>(entry.written.size()))
+            entry.until = entry.oldest;
+    }
+
+    stateQuery.finish();
+
+    if (!writeQueue())
+        return false;
+
+    if (!barsQuery.exec())
+        return fail(barsQuery);
+
+    bool more = barsQuery.next();
+
+    for (const auto& [symbol, entry] : queued) {
+        QString symbolText = QString::fromStdString(symbol);
+
+        tail.clear();
+
+        for (; more && barsQuery.value(0).toString() == symbolText; more = barsQuery.next()) {
+            BarData bar;
+
+            bar.Timestamp = barsQuery.value(1).toLongLong();
+            bar.Open = barsQuery.value(2).toDouble();
+            bar.High = barsQuery.value(3).toDouble();
+            bar.Low = barsQuery.value(4).toDouble();
+            bar.Close = barsQuery.value(5).toDouble();
+            bar.Volume = barsQuery.value(6).toLongLong();
+            tail.push_back(bar);
+        }
+
+        if (entry.until != std::numeric_limits<qint64>::max())
+            tail.insert(tail.end(), entry.written.begin(), entry.written.end());
+
+        if (!aggregate(symbolText, entry)) {
+            barsQuery.finish();
+
+            return false;
+        }
+    }
+
+    barsQuery.finish();
+
+    if (!writeUpserts())
+        return false;
+
+    if (!clearQuery.exec())
+        return fail(clearQuery);
+
+    discard();
+
+    return true;
+}
+
+bool RollupCache::aggregate(const QString& symbol, const Queued& entry) {
+    for (std::size_t i = 0; i < cachedTimeframes.size(); ++i) {
+        // Each timeframe starts at its own bucket boundary, a bucket that began before it would be stored half full
+        auto first = std::lower_bound(tail.begin(), tail.end(), entry.since[i], [](const BarData& bar, qint64 timestamp) {
+            return bar.Timestamp < timestamp;
+        });
+
+        touched.clear();
+        BarAggregator::aggregate(std::span<const BarData>(first, tail.end()), cachedTimeframes[i], touched);
+
+        QString timeframeText = BarAggregator::timeframeName(cachedTimeframes[i]);
+
+        for (const RollupBar& rollup : touched) {
+            symbols << symbol;
+            timeframes << timeframeText;
+            timestamps << rollup.Timestamp;
+            opens << rollup.Open;
+            highs << rollup.High;
+            lows << rollup.Low;
+            closes << rollup.Close;
+            volumes << rollup.Volume;
+            counts << rollup.BaseBars;
+            lastTimestamps << rollup.LastTimestamp;
+        }
+    }
+
+    // A backfill touches every bucket of the cache, those are written as they pile up rather than held until the end
+    if (symbols.size() >= rowsPerUpsert)
+        return writeUpserts();
+
+    return true;
+}
+
+bool RollupCache::writeUpserts() {
+    if (symbols.isEmpty())
+        return true;
+
+    upsertQuery.addBindValue(symbols);
+    upsertQuery.addBindValue(timeframes);
+    upsertQuery.addBindValue(timestamps);
+    upsertQuery.addBindValue(opens);
+    upsertQuery.addBindValue(highs);
+    upsertQuery.addBindValue(lows);
+    upsertQuery.addBindValue(closes);
+    upsertQuery.addBindValue(volumes);
+    upsertQuery.addBindValue(counts);
+    upsertQuery.addBindValue(lastTimestamps);
+
+    bool written = upsertQuery.execBatch();
+    qint64 count = symbols.size();
+
+    for (QVariantList* column : { &symbols, &timeframes, &timestamps, &opens, &highs, &lows, &closes, &volumes, &counts, &lastTimestamps })
+        column->clear();
+
+    if (!written)
+        return fail(upsertQuery);
+
+    rows += count;
+
+    return true;
+}
+
+bool RollupCache::invalidate(const std::string& symbol) {
+    deleteQuery.bindValue(":symbol", QString::fromStdString(symbol));
+
+    if (!deleteQuery.exec())
+        return fail(deleteQuery);
+
+    rows += deleteQuery.numRowsAffected();
+
+    return true;
+}
+
+bool RollupCache::backfill() {
+    QSqlQuery missingQuery(db);
+
+    if (!missingQuery.exec("SELECT DISTINCT symbol FROM historical_data WHERE symbol NOT IN (SELECT DISTINCT symbol FROM bar_rollups)"))
+        return fail(missingQuery);
+
+    // No rollups are stored for these, every bar is read back
+    while (missingQuery.next()) {
+        Queued& entry = queued[missingQuery.value(0).toString().toStdString()];
+
+        entry.oldest = everything;
+        entry.held = false;
+    }
+
+    missingQuery.finish();
+
+    if (queued.empty())
+        return true;
+
+    if (!db.transaction()) {
+        errorMessage = "Failed to start transaction: " + db.lastError().text();
+        discard();
+
+        return false;
+    }
+
+    if (!flush()) {
+        db.rollback();
+        discard();
+
+        return false;
+    }
+
+    if (!db.commit()) {
+        errorMessage = "Failed to commit transaction: " + db.lastError().text();
+        db.rollback();
+
+        return false;
+    }
+
+    return true;
+}
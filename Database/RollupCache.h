@@ -0,0 +1,99 @@
+#ifndef ROLLUP_CACHE_H
+#define ROLLUP_CACHE_H
+
+#include "Analysis/BarAggregator.h"
+#include "Core/MarketData.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariantList>
+#include <array>
+#include <cstddef>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+// Keeps bar_rollups in step with the daily bars in historical_data. Writes only queue the symbol and its new bars, flush
+// then re-aggregates every queued symbol from the start of its newest stored bucket in a handful of set-based statements.
+// A flush reads back at most the older part of a month of bars per symbol however long the history is, and the overlap
+// bar BarSync fetches again simply lands in the bucket it was already part of.
+class RollupCache {
+public:
+    // Timeframes kept in bar_rollups, days are historical_data itself
+    static constexpr std::array<Timeframe, 2> cachedTimeframes = { Timeframe::Week, Timeframe::Month };
+
+    // Written bars kept in memory until the flush, the bars of symbols queued beyond that are read back instead
+    static constexpr std::size_t heldBars = 1 << 20;
+
+    // Buckets collected before they are written in one batch
+    static constexpr int rowsPerUpsert = 10000;
+
+    static bool isCached(Timeframe timeframe);
+
+    explicit RollupCache(QSqlDatabase& database);
+
+    // Prepares every statement, must succeed before anything is written
+    bool prepare();
+
+    // Queues the symbol once its new bars are stored, bars are the ones just written. Nothing is read or written yet.
+    void apply(const std::string& symbol, std::span<const BarData> bars);
+
+    // Drops the symbol's rollups, the next flush after an apply rebuilds them from every stored bar
+    bool invalidate(const std::string& symbol);
+
+    // Call inside the writer's transaction before it commits, refreshes every symbol queued since the last flush
+    bool flush();
+
+    // Forgets the queued symbols, e.g. when the writer's transaction is rolled back
+    void discard();
+
+    // Rolls up every symbol that has bars but no rollups yet, e.g. in a cache written before rollups existed.
+    // Runs in its own transaction.
+    bool backfill();
+
+    const QString& lastError() const;
+    qint64 rowsWritten() const;
+
+private:
+    struct Queued {
+        qint64 oldest = 0;                                    // Oldest bar written since the last flush
+        bool held = true;                                     // Whether written holds every bar written since then
+        std::vector<BarData> written;
+        std::array<qint64, cachedTimeframes.size()> since{};  // Where each entry of cachedTimeframes is re-aggregated from
+        qint64 until = 0;                                     // Bars from here on are taken from written, not read back
+    };
+
+    QSqlDatabase& db;
+
+    QSqlQuery queueQuery;
+    QSqlQuery stateQuery;
+    QSqlQuery barsQuery;
+    QSqlQuery clearQuery;
+    QSqlQuery upsertQuery;
+    QSqlQuery deleteQuery;
+
+    // Ordered like the symbols of barsQuery, so one walk pairs them up
+    std::map<std::string, Queued> queued;
+    std::size_t held = 0;   // Bars in all written vectors
+
+    // Reused across symbols
+    std::vector<BarData> tail;
+    std::vector<RollupBar> touched;
+    QVariantList symbols, timeframes, timestamps, opens, highs, lows, closes, volumes, counts, lastTimestamps;
+
+    QString errorMessage;
+    qint64 rows = 0;
+
+    // Fills the temporary queue table from queued
+    bool writeQueue();
+
+    // Writes rollups of tail, the symbol's bars from the oldest of its starts on
+    bool aggregate(const QString& symbol, const Queued& entry);
+
+    bool writeUpserts();
+    bool fail(const QSqlQuery& query);
+};
+
+#endif // ROLLUP_CACHE_H
@@ -0,0 +1,214 @@
+#include "SchemaMigrations.h"
+
+#include <QDateTime>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+
+const std::vector<SchemaMigrations::Migration>& SchemaMigrations::migrations() {
+    // Append new steps at the end, never edit one that has shipped
+    static const std::vector<Migration> steps = {
+        { 1, "Initial cache tables", {
+            "CREATE TABLE IF NOT EXISTS stocks ("
+            "id TEXT PRIMARY KEY, "         // Unique Asset ID (Defined by Alpaca)
+            "name TEXT, "                   // Company name
+            "symbol TEXT, "                 // Stock symbol
+            "excluded TINYINT DEFAULT 0, "  // Excluded from analysis flag (either 0 or 1)
+            "last_updated INTEGER)",        // Unix timestamp
+
+            "CREATE TABLE IF NOT EXISTS trades ("
+            "symbol TEXT PRIMARY KEY, "     // Stock symbol
+            "price REAL, "                  // Last Trade Price
+            "size INTEGER)",                // Size of Trade
+
+            "CREATE TABLE IF NOT EXISTS historical_data ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT, "  // Unique ID for each record
+            "symbol TEXT NOT NULL, "                  // Stock symbol
+            "timestamp TEXT NOT NULL, "               // Timestamp of the data point
+            "open REAL NOT NULL, "                    // Open price
+            "high REAL NOT NULL, "                    // High price
+            "low REAL NOT NULL, "                     // Low price
+            "close REAL NOT NULL, "                   // Close price
+            "volume INTEGER NOT NULL, "               // Trade volume
+            "FOREIGN KEY(symbol) REFERENCES stocks(symbol))",
+
+            "CREATE TABLE IF NOT EXISTS scores ("
+            "symbol TEXT PRIMARY KEY, "           // Stock symbol
+            "ma_score REAL NOT NULL, "            // Moving Average Score
+            "rsi_score REAL NOT NULL, "           // Relative Strength Index Score
+            "bb_score REAL NOT NULL, "            // Bollinger Bands Score
+            "total_score REAL NOT NULL)"          // Total Weighted Score
+        }},
+        { 2, "Key historical_data by (symbol, timestamp) with epoch timestamps, index lookups", {
+            // Clustered on the key, so one symbol's bars sit together and range scans by time need no extra index
+            "CREATE TABLE historical_data_v2 ("
+            "symbol TEXT NOT NULL, "          // Stock symbol
+            "timestamp INTEGER NOT NULL, "    // Unix timestamp of the bar
+            "open REAL NOT NULL, "            // Open price
+            "high REAL NOT NULL, "            // High price
+            "low REAL NOT NULL, "             // Low price
+            "close REAL NOT NULL, "           // Close price
+            "volume INTEGER NOT NULL, "       // Trade volume
+            "PRIMARY KEY (symbol, timestamp)) WITHOUT ROWID",
+
+            // Older rows hold either epoch seconds or ISO 8601 text, duplicates keep the most recently inserted bar
+            "INSERT OR REPLACE INTO historical_data_v2 (symbol, timestamp, open, high, low, close, volume) "
+            "SELECT symbol, epoch, open, high, low, close, volume FROM ("
+            "    SELECT id, symbol, open, high, low, close, volume, "
+            "           CASE WHEN timestamp NOT GLOB '*[^0-9]*' AND timestamp <> '' THEN CAST(timestamp AS INTEGER) "
+            "                ELSE CAST(strftime('%s', timestamp) AS INTEGER) END AS epoch "
+            "    FROM historical_data) "
+            "WHERE epoch IS NOT NULL ORDER BY id",
+
+            "DROP TABLE historical_data",
+            "ALTER TABLE historical_data_v2 RENAME TO historical_data",
+
+            // Symbol lookups on stocks and score threshold filters no longer scan the whole table
+            "CREATE INDEX IF NOT EXISTS idx_stocks_symbol ON stocks (symbol)",
+            "CREATE INDEX IF NOT EXISTS idx_scores_total_score ON scores (total_score)"
+        }},
+        { 3, "Per-symbol running indicator sums", {
+            "CREATE TABLE IF NOT EXISTS indicator_state ("
+            "symbol TEXT PRIMARY KEY, "              // Stock symbol
+            "last_timestamp INTEGER NOT NULL, "      // Unix timestamp of the newest bar in the window
+            "count INTEGER NOT NULL, "               // Closes in the window
+            "sum REAL NOT NULL, "                    // Sum of closes
+            "sum_squares REAL NOT NULL, "            // Sum of squared closes
+            "gain_sum REAL NOT NULL, "               // Sum of upward moves
+            "loss_sum REAL NOT NULL, "               // Sum of downward moves
+            "down_moves INTEGER NOT NULL, "          // Number of downward moves
+            "last_close REAL NOT NULL)"              // Newest close
+        }},
+        { 4, "Weekly and monthly rollups of the daily bars", {
+            // Clustered like historical_data, one symbol's buckets of a timeframe are a single range
+            "CREATE TABLE IF NOT EXISTS bar_rollups ("
+            "symbol TEXT NOT NULL, "              // Stock symbol
+            "timeframe TEXT NOT NULL, "           // Alpaca timeframe name, e.g. 1Week
+            "timestamp INTEGER NOT NULL, "        // Unix timestamp at which the bucket starts
+            "open REAL NOT NULL, "                // Open of the first base bar
+            "high REAL NOT NULL, "                // Highest high
+            "low REAL NOT NULL, "                 // Lowest low
+            "close REAL NOT NULL, "               // Close of the last base bar
+            "volume INTEGER NOT NULL, "           // Summed volume
+            "bar_count INTEGER NOT NULL, "        // Base bars in the bucket
+            "last_timestamp INTEGER NOT NULL, "   // Unix timestamp of the newest base bar
+            "PRIMARY KEY (symbol, timeframe, timestamp)) WITHOUT ROWID"
+        }},
+        { 5, "Indicator sums relative to a shift close", {
+            // sum and sum_squares become sums of close - shift, rows written before hold plain sums, which is a shift of 0
+            "ALTER TABLE indicator_state ADD COLUMN shift REAL NOT NULL DEFAULT 0"
+        }}
+    };
+
+    return steps;
+}
+
+int SchemaMigrations::latestVersion() {
+    return migrations().back().version;
+}
+
+int SchemaMigrations::version(QSqlDatabase& db) {
+    QSqlQuery versionQuery(db);
+
+    if (!versionQuery.exec("SELECT MAX(version) FROM schema_version") || !versionQuery.next())
+        return 0;
+
+    return versionQuery.value(0).toInt();
+}
+
+bool SchemaMigrations::migrate(QSqlDatabase& db, QString& errorMessage, QStringList* applied) {
+    QSqlQuery createVersionTableQuery(db);
+
+    if (!createVersionTableQuery.exec("CREATE TABLE IF NOT EXISTS schema_version ("
+                                      "version INTEGER PRIMARY KEY, "   // Migration step
+                                      "applied_at INTEGER NOT NULL)")) { // Unix timestamp
+        errorMessage = "Query execution failed:" + createVersionTableQuery.lastError().text();
+
+        return false;
+    }
+
+    int current = version(db);
+
+    if (current > latestVersion()) {
+        errorMessage = QString("Cache schema version %1 is newer than this build supports (%2)").arg(current).arg(latestVersion());
+
+        return false;
+    }
+
+    for (const Migration& migration : migrations()) {
+        if (migration.version <= current)
+            continue;
+
+        bool ran = false;
+
+        if (!apply(db, migration, errorMessage, ran))
+            return false;
+
+        if (ran && applied)
+            applied->append(QString("Migrated cache schema to version %1: %2").arg(migration.version).arg(migration.description));
+    }
+
+    return true;
+}
+
+bool SchemaMigrations::apply(QSqlDatabase& db, const Migration& migration, QString& errorMessage, bool& ran) {
+    QSqlQuery transactionQuery(db);
+
+    ran = false;
+
+    // Takes the write lock up front, a deferred BEGIN would let two connections read the same version and both migrate
+    if (!transactionQuery.exec("BEGIN IMMEDIATE")) {
+        errorMessage = "Failed to start migration transaction: " + transactionQuery.lastError().text();
+
+        return false;
+    }
+
+    auto rollback = [&]() {
+        transactionQuery.exec("ROLLBACK");
+    };
+
+    // Another connection may have finished this step while we waited for the lock
+    if (version(db) >= migration.version) {
+        rollback();
+
+        return true;
+    }
+
+    for (const char* statement : migration.statements) {
+        QSqlQuery migrationQuery(db);
+
+        if (!migrationQuery.exec(statement)) {
+            errorMessage = QString("Migration to version %1 failed: %2").arg(migration.version).arg(migrationQuery.lastError().text());
+            migrationQuery.finish();
+            rollback();
+
+            return false;
+        }
+    }
+
+    QSqlQuery recordVersionQuery(db);
+
+    recordVersionQuery.prepare("INSERT INTO schema_version (version, applied_at) VALUES (:version, :appliedAt)");
+    recordVersionQuery.bindValue(":version", migration.version);
+    recordVersionQuery.bindValue(":appliedAt", QDateTime::currentSecsSinceEpoch());
+
+    if (!recordVersionQuery.exec()) {
+        errorMessage = QString("Failed to record schema version %1: %2").arg(migration.version).arg(recordVersionQuery.lastError().text());
+        rollback();
+
+        return false;
+    }
+
+    recordVersionQuery.finish();
+
+    if (!transactionQuery.exec("COMMIT")) {
+        errorMessage = QString("Failed to commit schema version %1: %2").arg(migration.version).arg(transactionQuery.lastError().text());
+        rollback();
+
+        return false;
+    }
+
+    ran = true;
+
+    return true;
+}
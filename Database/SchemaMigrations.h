@@ -0,0 +1,33 @@
+#ifndef SCHEMA_MIGRATIONS_H
+#define SCHEMA_MIGRATIONS_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// Brings cache.db up to the current layout one numbered step at a time, recording progress in schema_version
+class SchemaMigrations {
+public:
+    // Applies every migration newer than the database's version, each in its own transaction. A line describing each
+    // step is appended to applied, if given, for the caller to report.
+    static bool migrate(QSqlDatabase& db, QString& errorMessage, QStringList* applied = nullptr);
+
+    // 0 for a database that predates schema_version
+    static int version(QSqlDatabase& db);
+    static int latestVersion();
+
+private:
+    struct Migration {
+        int version;
+        const char* description;
+        std::vector<const char*> statements;
+    };
+
+    static const std::vector<Migration>& migrations();
+
+    // ran is false if another connection had already applied the step
+    static bool apply(QSqlDatabase& db, const Migration& migration, QString& errorMessage, bool& ran);
+};
+
+#endif // SCHEMA_MIGRATIONS_H
@@ -1,11 +1,16 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "Analysis/StockAnalysis.h"
+#include "Core/ScanEngine.h"
+#include "Core/LiveWorker.h"
+#include "Core/ScanWorker.h"
+#include "StockTableModel.h"
 
 #include <QSqlDatabase>
 #include <QMainWindow>
+#include <QPointer>
 #include <QStringList>
+#include <QThread>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -22,31 +27,46 @@ public:
 
 private slots:
     void onSearchButtonClicked();
+    void onScanProgress(int processed, int total, const QString& symbol);
+    void onScanResult(const StockInformation& info);
+    void onScanFailed(const QString& message);
+    void onScanMetrics(const QString& summary);
+    void onScanFinished(bool cancelled);
+    void onFilterChanged(const QString& text);
+    void onLiveButtonToggled(bool checked);
+    void onLiveRowsUpdated(const QVector<StockInformation>& rows);
+    void onLiveRowsExcluded(const QStringList& symbols);
+    void onLiveFinished();
 
 private:
     Ui::MainWindow* ui;
 
     QSqlDatabase db;
+    QString dbPath;
 
-    struct StockInformation {
-        std::string Name;
-        double Price;
-        double MA_Score;
-        double RSI_Score;
-        double BB_Score;
-        double Total_Score;
-    };
+    // Background scan, the thread is null while no scan is running. The worker is deleted as its thread finishes, which
+    // can be before onScanFinished runs, so both are guarded.
+    QPointer<QThread> scanThread;
+    QPointer<ScanWorker> scanWorker;
+    bool scanFailed = false;
+    QString scanMetricsSummary;   // Stage timings of the last scan, shown after the candidate count
+
+    // Live trade stream, the thread is null while not streaming. The worker can finish and be deleted on its own when the
+    // stream closes, before onLiveFinished runs.
+    QPointer<QThread> liveThread;
+    QPointer<LiveWorker> liveWorker;
+
+    // Read once, the environment does not change while the window is open
+    ScoreWeights weights;
+    CandidateLimits candidateLimits;
 
     const std::string exchange = "NYSE";
     const std::string userAgent = "StockHound/1.0";
 
-    // Map to store all stock information
-    std::unordered_map<std::string, StockInformation> stockInfoMap;
+    // Results of the current scan, rows are added as the worker reports them
+    StockTableModel* stockModel = nullptr;
 
-    void refreshStockList();
-    void addRowToTable(const QString& name, const QString& ticker, double price, double ma_score, double rsi_score, double bb_score, double total_score);
-    void updateScoresDatabase(const std::string symbol, const std::vector<double> scores);
-    void excludeSuspiciousScores();
+    void stopLive(bool wait);
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,303 @@
+#include "StockTableModel.h"
+
+#include <algorithm>
+
+namespace {
+    double numericValue(const StockInformation& info, int column) {
+        switch (column) {
+            case StockTableModel::PriceColumn:
+                return info.Price;
+            case StockTableModel::MAScoreColumn:
+                return info.MA_Score;
+            case StockTableModel::RSIScoreColumn:
+                return info.RSI_Score;
+            case StockTableModel::BBScoreColumn:
+                return info.BB_Score;
+            default:
+                return info.Total_Score;
+        }
+    }
+}
+
+StockTableModel::StockTableModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+int StockTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(visibleRows.size());
+}
+
+int StockTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+int StockTableModel::stockCount() const {
+    return static_cast<int>(stocks.size());
+}
+
+const std::vector<StockInformation>& StockTableModel::results() const {
+    return stocks;
+}
+
+QVariant StockTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= static_cast<int>(visibleRows.size()))
+        return QVariant();
+
+    const StockInformation& info = stocks[visibleRows[index.row()]];
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+            case NameColumn:
+                return QString::fromStdString(info.Name);
+            case TickerColumn:
+                return QString::fromStdString(info.Symbol);
+            default:
+                return QString::number(numericValue(info, index.column()), 'f', 2);
+        }
+    }
+
+    if (role == Qt::TextAlignmentRole && index.column() >= PriceColumn)
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+
+    return QVariant();
+}
+
+QVariant StockTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+        case NameColumn:
+            return QString("Name");
+        case TickerColumn:
+            return QString("Ticker");
+        case PriceColumn:
+            return QString("Price");
+        case MAScoreColumn:
+            return QString("MA Score");
+        case RSIScoreColumn:
+            return QString("RSI Score");
+        case BBScoreColumn:
+            return QString("BB Score");
+        case TotalScoreColumn:
+            return QString("Total Score");
+        default:
+            return QVariant();
+    }
+}
+
+bool StockTableModel::accepts(const StockInformation& info) const {
+    if (filterText.isEmpty())
+        return true;
+
+    return QString::fromStdString(info.Symbol).contains(filterText, Qt::CaseInsensitive) ||
+           QString::fromStdString(info.Name).contains(filterText, Qt::CaseInsensitive);
+}
+
+bool StockTableModel::lessThan(int left, int right) const {
+    const StockInformation& a = stocks[left];
+    const StockInformation& b = stocks[right];
+
+    if (sortColumn == NameColumn)
+        return QString::fromStdString(a.Name).compare(QString::fromStdString(b.Name), Qt::CaseInsensitive) < 0;
+
+    if (sortColumn == TickerColumn)
+        return a.Symbol < b.Symbol;
+
+    return numericValue(a, sortColumn) < numericValue(b, sortColumn);
+}
+
+int StockTableModel::sortedPosition(int stock) const {
+    // After any equal rows, so rows that arrive later go below ones with the same key
+    auto position = std::upper_bound(visibleRows.begin(), visibleRows.end(), stock, [this](int candidate, int row) {
+        return sortOrder == Qt::AscendingOrder ? lessThan(candidate, row) : lessThan(row, candidate);
+    });
+
+    return static_cast<int>(position - visibleRows.begin());
+}
+
+int StockTableModel::visibleRow(int stock) const {
+    return rowOfStock[stock];
+}
+
+void StockTableModel::renumber(int first, int last) {
+    for (int row = first; row < last; ++row)
+        rowOfStock[visibleRows[row]] = row;
+}
+
+void StockTableModel::renumberAll() {
+    rowOfStock.assign(stocks.size(), -1);
+    renumber(0, static_cast<int>(visibleRows.size()));
+}
+
+void StockTableModel::upsert(const StockInformation& info) {
+    auto existing = stockIndex.find(info.Symbol);
+
+    if (existing == stockIndex.end()) {
+        int stock = static_cast<int>(stocks.size());
+
+        stocks.push_back(info);
+        stockIndex.emplace(info.Symbol, stock);
+        rowOfStock.push_back(-1);
+
+        if (!accepts(info))
+            return;
+
+        int row = sortedPosition(stock);
+
+        beginInsertRows(QModelIndex(), row, row);
+        visibleRows.insert(visibleRows.begin() + row, stock);
+        renumber(row, static_cast<int>(visibleRows.size()));
+        endInsertRows();
+
+        return;
+    }
+
+    int stock = existing->second;
+    int row = visibleRow(stock);
+
+    stocks[stock] = info;
+
+    bool visible = accepts(info);
+
+    if (row < 0) {
+        if (visible) {
+            int newRow = sortedPosition(stock);
+
+            beginInsertRows(QModelIndex(), newRow, newRow);
+            visibleRows.insert(visibleRows.begin() + newRow, stock);
+            renumber(newRow, static_cast<int>(visibleRows.size()));
+            endInsertRows();
+        }
+
+        return;
+    }
+
+    if (!visible) {
+        beginRemoveRows(QModelIndex(), row, row);
+        visibleRows.erase(visibleRows.begin() + row);
+        rowOfStock[stock] = -1;
+        renumber(row, static_cast<int>(visibleRows.size()));
+        endRemoveRows();
+
+        return;
+    }
+
+    // Take the row out, find where it belongs now and move it there if that is somewhere else
+    visibleRows.erase(visibleRows.begin() + row);
+
+    int newRow = sortedPosition(stock);
+
+    visibleRows.insert(visibleRows.begin() + row, stock);
+
+    if (newRow != row) {
+        // beginMoveRows expects the destination in terms of the rows before the move
+        int destination = newRow > row ? newRow + 1 : newRow;
+
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), destination);
+        visibleRows.erase(visibleRows.begin() + row);
+        visibleRows.insert(visibleRows.begin() + newRow, stock);
+
+        // Only the rows between the old and the new position shifted
+        renumber(std::min(row, newRow), std::max(row, newRow) + 1);
+        endMoveRows();
+    }
+
+    emit dataChanged(index(newRow, 0), index(newRow, ColumnCount - 1));
+}
+
+void StockTableModel::remove(const std::string& symbol) {
+    auto existing = stockIndex.find(symbol);
+
+    if (existing == stockIndex.end())
+        return;
+
+    int stock = existing->second;
+    int row = visibleRow(stock);
+    int last = static_cast<int>(stocks.size()) - 1;
+
+    if (row >= 0) {
+        beginRemoveRows(QModelIndex(), row, row);
+        visibleRows.erase(visibleRows.begin() + row);
+        renumber(row, static_cast<int>(visibleRows.size()));
+    }
+
+    // The last stock fills the gap, so no other stock index changes
+    if (stock != last) {
+        stocks[stock] = std::move(stocks[last]);
+        stockIndex[stocks[stock].Symbol] = stock;
+        rowOfStock[stock] = rowOfStock[last];
+
+        if (rowOfStock[stock] >= 0)
+            visibleRows[rowOfStock[stock]] = stock;
+    }
+
+    stockIndex.erase(existing);
+    stocks.pop_back();
+    rowOfStock.pop_back();
+
+    if (row >= 0)
+        endRemoveRows();
+}
+
+void StockTableModel::clear() {
+    beginResetModel();
+    stocks.clear();
+    stockIndex.clear();
+    visibleRows.clear();
+    rowOfStock.clear();
+    endResetModel();
+}
+
+void StockTableModel::setFilterText(const QString& text) {
+    if (text == filterText)
+        return;
+
+    beginResetModel();
+    filterText = text;
+    visibleRows.clear();
+
+    for (int stock = 0; stock < static_cast<int>(stocks.size()); ++stock) {
+        if (accepts(stocks[stock]))
+            visibleRows.push_back(stock);
+    }
+
+    std::stable_sort(visibleRows.begin(), visibleRows.end(), [this](int left, int right) {
+        return sortOrder == Qt::AscendingOrder ? lessThan(left, right) : lessThan(right, left);
+    });
+    renumberAll();
+    endResetModel();
+}
+
+void StockTableModel::sort(int column, Qt::SortOrder order) {
+    if (column < 0 || column >= ColumnCount)
+        return;
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // Remember which stock each persistent index (selection, current row) points at
+    QModelIndexList oldIndexes = persistentIndexList();
+    std::vector<int> oldStocks;
+
+    oldStocks.reserve(oldIndexes.size());
+
+    for (const QModelIndex& oldIndex : oldIndexes)
+        oldStocks.push_back(visibleRows[oldIndex.row()]);
+
+    sortColumn = column;
+    sortOrder = order;
+
+    std::stable_sort(visibleRows.begin(), visibleRows.end(), [this](int left, int right) {
+        return sortOrder == Qt::AscendingOrder ? lessThan(left, right) : lessThan(right, left);
+    });
+
+    // Map each stock to its new row once, then move the persistent indexes along
+    renumberAll();
+
+    QModelIndexList newIndexes;
+
+    for (int i = 0; i < oldIndexes.size(); ++i)
+        newIndexes.append(index(rowOfStock[oldStocks[i]], oldIndexes[i].column()));
+
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
@@ -0,0 +1,71 @@
+#ifndef STOCK_TABLE_MODEL_H
+#define STOCK_TABLE_MODEL_H
+
+#include "Core/ScanEngine.h"
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Scan results for the table view. Rows live in one contiguous vector and are only formatted when the view asks for
+// them, sorting and filtering reorder a vector of row indexes instead of copying items around.
+class StockTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn,
+        TickerColumn,
+        PriceColumn,
+        MAScoreColumn,
+        RSIScoreColumn,
+        BBScoreColumn,
+        TotalScoreColumn,
+        ColumnCount
+    };
+
+    explicit StockTableModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Adds a new symbol at its sorted position, or updates the row already showing it
+    void upsert(const StockInformation& info);
+
+    // Drops the symbol's row, e.g. once a live rescore excludes it
+    void remove(const std::string& symbol);
+    void clear();
+
+    // Case-insensitive match on name or ticker, an empty filter shows every row
+    void setFilterText(const QString& text);
+
+    // Every stored result, including rows hidden by the filter
+    int stockCount() const;
+    const std::vector<StockInformation>& results() const;
+
+private:
+    std::vector<StockInformation> stocks;
+    std::unordered_map<std::string, int> stockIndex;
+    std::vector<int> visibleRows; // Stock indexes in display order
+    std::vector<int> rowOfStock;  // Inverse of visibleRows, -1 for stocks the filter hides
+
+    int sortColumn = TotalScoreColumn;
+    Qt::SortOrder sortOrder = Qt::DescendingOrder;
+    QString filterText;
+
+    bool accepts(const StockInformation& info) const;
+    bool lessThan(int left, int right) const;
+    int sortedPosition(int stock) const;
+    int visibleRow(int stock) const;
+
+    // Brings rowOfStock in line for visible rows [first, last), after rows in that range moved
+    void renumber(int first, int last);
+    void renumberAll();
+};
+
+#endif // STOCK_TABLE_MODEL_H
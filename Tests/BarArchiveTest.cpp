@@ -0,0 +1,189 @@
+#include "Database/BarArchive.h"
+#include "Database/CacheWriter.h"
+#include "Database/SchemaMigrations.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QVariant>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// Imports bars from one cache into an archive, appends to it, reopens it and exports it into a second cache, then
+// checks that the second cache holds exactly the bars that went in. Symbols whose file names used to collide are
+// archived side by side. Any mismatch makes it exit with 1 so ctest reports it.
+
+namespace {
+    int failures = 0;
+
+    using History = std::map<std::string, std::vector<BarData>>;
+
+    void check(bool condition, const std::string& message) {
+        if (condition)
+            return;
+
+        if (++failures <= 20)
+            std::fprintf(stderr, "%s\n", message.c_str());
+    }
+
+    BarData bar(qint64 day, double close) {
+        return BarData{ 1704205800 + day * 86400, close - 0.5, close + 1.0, close - 1.0, close, 1000 + day };
+    }
+
+    std::vector<BarData> days(qint64 first, qint64 last, double base) {
+        std::vector<BarData> bars;
+
+        for (qint64 day = first; day <= last; ++day)
+            bars.push_back(bar(day, base + day * 0.25));
+
+        return bars;
+    }
+
+    bool openCache(QSqlDatabase& db, const QString& connection, const QString& path) {
+        QStringList applied;
+        QString errorMessage;
+
+        db = QSqlDatabase::addDatabase("QSQLITE", connection);
+        db.setDatabaseName(path);
+
+        if (!db.open() || !SchemaMigrations::migrate(db, errorMessage, &applied)) {
+            std::fprintf(stderr, "Opening %s failed: %s\n", qPrintable(path), qPrintable(errorMessage));
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool writeCache(QSqlDatabase& db, const History& history) {
+        CacheWriter writer(db);
+
+        if (!writer.prepare())
+            return false;
+
+        for (const auto& [symbol, bars] : history) {
+            if (!writer.nextSymbol() || !writer.writeBars(symbol, bars))
+                return false;
+        }
+
+        return writer.commit();
+    }
+
+    History readCache(QSqlDatabase& db) {
+        History history;
+        QSqlQuery query(db);
+
+        query.exec("SELECT symbol, timestamp, open, high, low, close, volume FROM historical_data ORDER BY symbol, timestamp");
+
+        while (query.next()) {
+            history[query.value(0).toString().toStdString()].push_back({ query.value(1).toLongLong(), query.value(2).toDouble(),
+                                                                         query.value(3).toDouble(), query.value(4).toDouble(),
+                                                                         query.value(5).toDouble(), query.value(6).toLongLong() });
+        }
+
+        return history;
+    }
+
+    void compare(const History& actual, const History& expected) {
+        check(actual.size() == expected.size(), "Exported " + std::to_string(actual.size()) + " symbols, expected " + std::to_string(expected.size()));
+
+        for (const auto& [symbol, bars] : expected) {
+            auto found = actual.find(symbol);
+
+            if (found == actual.end()) {
+                check(false, symbol + " is missing from the export");
+
+                continue;
+            }
+
+            check(found->second.size() == bars.size(), symbol + ": exported " + std::to_string(found->second.size()) + " bars, expected " + std::to_string(bars.size()));
+
+            for (std::size_t i = 0; i < std::min(bars.size(), found->second.size()); ++i) {
+                const BarData& a = found->second[i];
+                const BarData& b = bars[i];
+
+                check(a.Timestamp == b.Timestamp && a.Open == b.Open && a.High == b.High && a.Low == b.Low && a.Close == b.Close && a.Volume == b.Volume,
+                      symbol + ": bar " + std::to_string(i) + " differs");
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication application(argc, argv);
+    QTemporaryDir directory;
+
+    if (!directory.isValid()) {
+        std::fprintf(stderr, "No temporary directory\n");
+
+        return 1;
+    }
+
+    // BRK/B and BRK_B both used to be stored as BRK_B.bars, brk_b only differs from BRK_B in case
+    History expected = {
+        { "AAPL", days(0, 99, 180.0) },
+        { "BRK/B", days(0, 59, 410.0) },
+        { "BRK_B", days(10, 79, 95.0) },
+        { "brk_b", days(20, 39, 12.0) },
+    };
+
+    QSqlDatabase source;
+    QSqlDatabase target;
+
+    if (!openCache(source, "source", directory.filePath("source.db")) || !writeCache(source, expected))
+        return 1;
+
+    {
+        BarArchive archive(directory.filePath("archive"));
+
+        check(archive.open(), "Opening the archive failed: " + archive.lastError().toStdString());
+        check(archive.importFrom(source), "Import failed: " + archive.lastError().toStdString());
+
+        // Newer bars are appended, ones the archive already holds are skipped
+        for (auto& [symbol, bars] : expected) {
+            std::vector<BarData> more = days(100, 109, bars.front().Close);
+
+            more.insert(more.begin(), bars.back());
+            check(archive.append(symbol, more), "Appending to " + symbol + " failed: " + archive.lastError().toStdString());
+            bars.insert(bars.end(), more.begin() + 1, more.end());
+        }
+
+        check(archive.close(), "Closing the archive failed: " + archive.lastError().toStdString());
+    }
+
+    // Without the index every data file is scanned again
+    QFile::remove(directory.filePath("archive/archive.idx"));
+
+    {
+        BarArchive archive(directory.filePath("archive"));
+
+        check(archive.open(), "Reopening the archive failed: " + archive.lastError().toStdString());
+        check(archive.entries().size() == expected.size(), "The archive lists " + std::to_string(archive.entries().size()) + " symbols");
+
+        if (!openCache(target, "target", directory.filePath("target.db")))
+            return 1;
+
+        check(archive.exportTo(target), "Export failed: " + archive.lastError().toStdString());
+        compare(readCache(target), expected);
+
+        // A data file holding another symbol's bars is refused rather than truncated
+        QFile::copy(directory.filePath("archive/AAPL.bars"), directory.filePath("archive/MSFT.bars"));
+        check(!archive.append("MSFT", days(0, 1, 300.0)), "Appending to a file of another symbol succeeded");
+        check(archive.bars("AAPL").size() == expected["AAPL"].size(), "AAPL lost bars to a refused append");
+        check(archive.close(), "Closing the archive failed: " + archive.lastError().toStdString());
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d mismatches\n", failures);
+
+        return 1;
+    }
+
+    std::printf("The bar archive round trip matches\n");
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "Analysis/IndicatorKernels.h"
+#include "Analysis/IndicatorPipeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// Checks that the SSE2 and AVX2 kernels, on the CPUs that have them, and the scoring pipeline's close sums give the
+// indicators of the scalar kernel. Any mismatch makes it exit with 1 so ctest reports it.
+
+namespace {
+    int failures = 0;
+
+    // The vector kernels add in a different order, so only rounding may differ
+    bool close(double actual, double expected) {
+        return std::abs(actual - expected) <= 1e-9 * std::max(1.0, std::abs(expected));
+    }
+
+    void check(const std::string& context, const Indicators& actual, const Indicators& expected) {
+        if (close(actual.MovingAverage, expected.MovingAverage) && close(actual.RSI, expected.RSI) &&
+            close(actual.UpperBand, expected.UpperBand) && close(actual.LowerBand, expected.LowerBand))
+            return;
+
+        if (++failures <= 20) {
+            std::fprintf(stderr, "%s: MA %.12g RSI %.12g bands %.12g..%.12g, expected MA %.12g RSI %.12g bands %.12g..%.12g\n",
+                         context.c_str(), actual.MovingAverage, actual.RSI, actual.LowerBand, actual.UpperBand,
+                         expected.MovingAverage, expected.RSI, expected.LowerBand, expected.UpperBand);
+        }
+    }
+
+    // Scalar always, then every vector level up to the one this CPU runs, which STOCKHOUND_SIMD can lower
+    std::vector<SimdLevel> supportedLevels() {
+        std::vector<SimdLevel> levels{ SimdLevel::Scalar };
+
+        if (IndicatorKernels::activeLevel() >= SimdLevel::SSE2)
+            levels.push_back(SimdLevel::SSE2);
+
+        if (IndicatorKernels::activeLevel() >= SimdLevel::AVX2)
+            levels.push_back(SimdLevel::AVX2);
+
+        return levels;
+    }
+
+    std::vector<double> randomWalk(std::mt19937_64& random, std::size_t count, double start, double volatility) {
+        std::normal_distribution<double> change(0.0, volatility);
+        std::vector<double> closes;
+        double price = start;
+
+        closes.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            price = std::max(0.01, price * (1.0 + change(random)));
+            closes.push_back(price);
+        }
+
+        return closes;
+    }
+
+    // Every level over the whole series and over its last period closes, the pipeline over the whole series
+    void compareLevels(const std::string& name, const std::vector<double>& closes) {
+        std::span<const double> all(closes);
+
+        for (int period : { 0, 10, 14, 31 }) {
+            if (static_cast<std::size_t>(period) > closes.size())
+                continue;
+
+            Indicators reference = IndicatorKernels::compute(all, period, SimdLevel::Scalar);
+
+            for (SimdLevel level : supportedLevels()) {
+                check(name + " " + IndicatorKernels::levelName(level) + " period " + std::to_string(period),
+                      IndicatorKernels::compute(all, period, level), reference);
+            }
+        }
+
+        // The scoring pipeline keeps its own close sums for MA, RSI and BB
+        ScoringPipeline pipeline;
+
+        pipeline.run(BarSeries{ {}, {}, {}, all, {} });
+        check(name + " pipeline", pipeline.get<WindowStatistics>().indicators(), IndicatorKernels::compute(all, 0, SimdLevel::Scalar));
+    }
+}
+
+int main() {
+    std::mt19937_64 random(20240611);
+
+    // Every length up to a few vector widths past the minimum, so each tail of the unrolled loops is taken
+    for (std::size_t count = 1; count <= 40; ++count)
+        compareLevels("random walk of " + std::to_string(count), randomWalk(random, count, 50.0, 0.02));
+
+    for (std::size_t count : { 250, 1001, 4099 })
+        compareLevels("random walk of " + std::to_string(count), randomWalk(random, count, 2.0 + count % 97, 0.02));
+
+    // Large prices with small moves, where the sums of squares are most sensitive to the order they are added in
+    compareLevels("expensive walk", randomWalk(random, 2000, 250000.0, 0.0005));
+
+    // No moves at all, the bands collapse onto the average and RSI is 100
+    compareLevels("flat walk", std::vector<double>(300, 42.5));
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d mismatches\n", failures);
+
+        return 1;
+    }
+
+    std::printf("Indicator kernels match the scalar loop at");
+
+    for (SimdLevel level : supportedLevels())
+        std::printf(" %s", IndicatorKernels::levelName(level));
+
+    std::printf("\n");
+
+    return 0;
+}
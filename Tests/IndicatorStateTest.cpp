@@ -0,0 +1,144 @@
+#include "Analysis/IndicatorKernels.h"
+#include "Analysis/IndicatorState.h"
+#include "Analysis/StockAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// Checks that IndicatorState, updated one bar at a time, gives the indicators and scores of a fresh pass over the same
+// window. Any mismatch makes it exit with 1 so ctest reports it.
+
+namespace {
+    int failures = 0;
+
+    bool close(double actual, double expected, double tolerance) {
+        // A flat window has no band width, both sides then score NaN the same way
+        if (std::isnan(actual) && std::isnan(expected))
+            return true;
+
+        return std::abs(actual - expected) <= tolerance * std::max(1.0, std::abs(expected));
+    }
+
+    void check(const std::string& context, const char* field, double actual, double expected, double tolerance) {
+        if (close(actual, expected, tolerance))
+            return;
+
+        if (++failures <= 20)
+            std::fprintf(stderr, "%s: %s is %.12g, expected %.12g\n", context.c_str(), field, actual, expected);
+    }
+
+    // Compares the state with the batch kernel and the scoring of the window it holds
+    void compare(const std::string& context, const IndicatorState& state, std::span<const double> window) {
+        Indicators actual = state.indicators();
+        Indicators expected = IndicatorKernels::compute(window, 0, SimdLevel::Scalar);
+
+        // The running sums add and drop each close once per step, the kernel sums the window afresh
+        check(context, "MovingAverage", actual.MovingAverage, expected.MovingAverage, 1e-9);
+        check(context, "UpperBand", actual.UpperBand, expected.UpperBand, 1e-7);
+        check(context, "LowerBand", actual.LowerBand, expected.LowerBand, 1e-7);
+        check(context, "RSI", actual.RSI, expected.RSI, 1e-7);
+
+        double price = window.back();
+        ScoreCard fromState = StockAnalysis::calculateTotalScores(price, actual);
+        ScoreCard fromPrices = StockAnalysis::calculateTotalScores(price, window, static_cast<int>(window.size()));
+
+        check(context, "Total_Score", fromState.Total_Score, fromPrices.Total_Score, 1e-7);
+    }
+
+    std::vector<double> randomWalk(std::mt19937_64& random, std::size_t count, double start, double volatility) {
+        std::normal_distribution<double> change(0.0, volatility);
+        std::vector<double> closes;
+        double price = start;
+
+        closes.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            price = std::max(0.01, price * (1.0 + change(random)));
+            closes.push_back(price);
+        }
+
+        return closes;
+    }
+
+    // A fixed window moved bar by bar over the whole walk
+    void slideOver(const std::string& name, const std::vector<double>& closes, std::size_t window) {
+        std::span<const double> all(closes);
+        IndicatorState state = IndicatorState::fromSeries(all.first(window), 0);
+
+        compare(name + " window " + std::to_string(window) + " at 0", state, all.first(window));
+
+        for (std::size_t first = 1; first + window <= closes.size(); ++first) {
+            std::size_t newest = first + window - 1;
+
+            state.slide(closes[first - 1], closes[first], closes[newest], static_cast<qint64>(newest));
+            compare(name + " window " + std::to_string(window) + " at " + std::to_string(first), state, all.subspan(first, window));
+        }
+    }
+
+    // Grows the window by pushes, then shrinks it from the front by pops
+    void pushThenPop(const std::string& name, const std::vector<double>& closes) {
+        std::span<const double> all(closes);
+        IndicatorState state;
+
+        for (std::size_t count = 1; count <= closes.size(); ++count) {
+            state.push(closes[count - 1], static_cast<qint64>(count));
+
+            if (count >= 10)
+                compare(name + " push " + std::to_string(count), state, all.first(count));
+        }
+
+        for (std::size_t first = 1; closes.size() - first >= 10; ++first) {
+            state.pop(closes[first - 1], closes[first]);
+            compare(name + " pop " + std::to_string(first), state, all.subspan(first));
+        }
+    }
+}
+
+int main() {
+    std::mt19937_64 random(20240611);
+
+    for (int walk = 0; walk < 20; ++walk) {
+        std::vector<double> closes = randomWalk(random, 600, 2.0 + walk * 25.0, 0.02);
+        std::string name = "random walk " + std::to_string(walk);
+
+        for (std::size_t window : { 10, 14, 30, 100 })
+            slideOver(name, closes, window);
+
+        pushThenPop(name, std::vector<double>(closes.begin(), closes.begin() + 200));
+    }
+
+    // Large prices with small moves are where unshifted sums of squares lose the variance to cancellation
+    std::vector<double> expensive = randomWalk(random, 2000, 250000.0, 0.0005);
+
+    slideOver("expensive walk", expensive, 30);
+    pushThenPop("expensive walk", std::vector<double>(expensive.begin(), expensive.begin() + 200));
+
+    // No moves at all, the bands collapse onto the average and RSI is 100
+    std::vector<double> flat(300, 42.5);
+
+    slideOver("flat walk", flat, 20);
+    pushThenPop("flat walk", flat);
+
+    // Flat stretches between moves, gains and losses have to drain back to exactly none
+    std::vector<double> steps;
+
+    for (int level = 0; level < 30; ++level)
+        steps.insert(steps.end(), 25, 100.0 + (level % 3) * 0.37);
+
+    slideOver("step walk", steps, 20);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d mismatches\n", failures);
+
+        return 1;
+    }
+
+    std::printf("IndicatorState matches the batch kernel\n");
+
+    return 0;
+}
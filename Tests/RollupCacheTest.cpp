@@ -0,0 +1,308 @@
+#include "Analysis/BarAggregator.h"
+#include "Database/CacheWriter.h"
+#include "Database/RollupCache.h"
+#include "Database/SchemaMigrations.h"
+
+#include <QCoreApplication>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QVariant>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Writes bars over many transactions the way scans and syncs do, then checks after every step that bar_rollups holds
+// exactly what BarAggregator::aggregate makes of each symbol's full history. Any mismatch makes it exit with 1 so ctest
+// reports it.
+
+namespace {
+    int failures = 0;
+
+    using History = std::map<std::string, std::vector<BarData>>;
+    using Key = std::tuple<std::string, std::string, qint64>;
+    using Row = std::tuple<double, double, double, double, qint64, int, qint64>;
+
+    void check(bool condition, const std::string& message) {
+        if (condition)
+            return;
+
+        if (++failures <= 20)
+            std::fprintf(stderr, "%s\n", message.c_str());
+    }
+
+    std::map<Key, Row> stored(QSqlDatabase& db) {
+        std::map<Key, Row> rollups;
+        QSqlQuery query(db);
+
+        query.exec("SELECT symbol, timeframe, timestamp, open, high, low, close, volume, bar_count, last_timestamp FROM bar_rollups");
+
+        while (query.next()) {
+            rollups[{ query.value(0).toString().toStdString(), query.value(1).toString().toStdString(), query.value(2).toLongLong() }] =
+                Row{ query.value(3).toDouble(), query.value(4).toDouble(), query.value(5).toDouble(), query.value(6).toDouble(),
+                     query.value(7).toLongLong(), query.value(8).toInt(), query.value(9).toLongLong() };
+        }
+
+        return rollups;
+    }
+
+    std::map<Key, Row> expected(const History& history) {
+        std::map<Key, Row> rollups;
+        std::vector<RollupBar> buckets;
+
+        for (const auto& [symbol, bars] : history) {
+            for (Timeframe timeframe : RollupCache::cachedTimeframes) {
+                buckets.clear();
+                BarAggregator::aggregate(bars, timeframe, buckets);
+
+                for (const RollupBar& bucket : buckets) {
+                    rollups[{ symbol, BarAggregator::timeframeName(timeframe), bucket.Timestamp }] =
+                        Row{ bucket.Open, bucket.High, bucket.Low, bucket.Close, bucket.Volume, bucket.BaseBars, bucket.LastTimestamp };
+                }
+            }
+        }
+
+        return rollups;
+    }
+
+    void compare(QSqlDatabase& db, const History& history, const std::string& step) {
+        std::map<Key, Row> actual = stored(db);
+        std::map<Key, Row> wanted = expected(history);
+
+        check(actual.size() == wanted.size(), step + ": " + std::to_string(actual.size()) + " rollups stored, expected " + std::to_string(wanted.size()));
+
+        for (const auto& [key, row] : wanted) {
+            auto found = actual.find(key);
+
+            check(found != actual.end() && found->second == row,
+                  step + ": " + std::get<0>(key) + " " + std::get<1>(key) + " bucket " + std::to_string(std::get<2>(key)) + " differs");
+        }
+    }
+
+    // Keeps history oldest first with one bar per timestamp, the way historical_data stores it
+    void store(std::vector<BarData>& history, const std::vector<BarData>& bars) {
+        for (const BarData& bar : bars) {
+            auto position = std::lower_bound(history.begin(), history.end(), bar.Timestamp, [](const BarData& stored, qint64 timestamp) {
+                return stored.Timestamp < timestamp;
+            });
+
+            if (position != history.end() && position->Timestamp == bar.Timestamp)
+                *position = bar;
+            else
+                history.insert(position, bar);
+        }
+    }
+
+    class Market {
+    public:
+        // A weekday close about 14:30 New York time from the day after 2024-01-01 on
+        BarData bar(qint64 day) {
+            std::uniform_real_distribution<double> move(-1.0, 1.0);
+            double close = 50.0 + move(random) * 5.0;
+
+            return BarData{ 1704205800 + day * 86400, close - move(random), close + 1.0, close - 1.0, close, 1000 + static_cast<qint64>(day) };
+        }
+
+        std::vector<BarData> days(qint64 first, qint64 last) {
+            std::vector<BarData> bars;
+
+            for (qint64 day = first; day <= last; ++day) {
+                if ((day + 1) % 7 < 5)
+                    bars.push_back(bar(day));
+            }
+
+            return bars;
+        }
+
+    private:
+        std::mt19937_64 random{ 20240611 };
+    };
+
+    bool write(QSqlDatabase& db, const std::map<std::string, std::vector<std::vector<BarData>>>& writes, const std::vector<std::string>& deletes = {}) {
+        CacheWriter writer(db);
+
+        if (!writer.prepare()) {
+            std::fprintf(stderr, "%s\n", writer.lastError().toStdString().c_str());
+
+            return false;
+        }
+
+        for (const std::string& symbol : deletes) {
+            if (!writer.nextSymbol() || !writer.deleteBars(symbol))
+                return false;
+        }
+
+        for (const auto& [symbol, batches] : writes) {
+            if (!writer.nextSymbol())
+                return false;
+
+            for (const std::vector<BarData>& bars : batches) {
+                if (!writer.writeBars(symbol, bars))
+                    return false;
+            }
+        }
+
+        if (!writer.commit()) {
+            std::fprintf(stderr, "%s\n", writer.lastError().toStdString().c_str());
+
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication application(argc, argv);
+    QTemporaryDir directory;
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    QString errorMessage;
+    Market market;
+    History history;
+
+    db.setDatabaseName(directory.filePath("cache.db"));
+
+    if (!directory.isValid() || !db.open() || !SchemaMigrations::migrate(db, errorMessage)) {
+        std::fprintf(stderr, "Opening the cache failed: %s\n", errorMessage.toStdString().c_str());
+
+        return 1;
+    }
+
+    const std::vector<std::string> symbols = { "AAA", "BBB", "CCC", "DDD" };
+    qint64 day = 90;
+
+    // First sync, whole histories with nothing stored yet
+    {
+        std::map<std::string, std::vector<std::vector<BarData>>> writes;
+
+        for (const std::string& symbol : symbols) {
+            writes[symbol] = { market.days(0, day - 1) };
+            store(history[symbol], writes[symbol].front());
+        }
+
+        check(write(db, writes), "First sync failed");
+        compare(db, history, "first sync");
+    }
+
+    // Delta syncs, the newest stored bar comes again with revised values together with one to six new days, so buckets
+    // stay open across transactions and weeks and months roll over in between
+    for (int round = 0; round < 40; ++round) {
+        std::map<std::string, std::vector<std::vector<BarData>>> writes;
+        qint64 newDays = 1 + round % 6;
+
+        for (const std::string& symbol : symbols) {
+            BarData overlap = history[symbol].back();
+
+            overlap.Close += 0.5;
+            overlap.High = std::max(overlap.High, overlap.Close);
+            overlap.Volume += 10;
+
+            std::vector<BarData> bars = { overlap };
+            std::vector<BarData> fresh = market.days(day, day + newDays - 1);
+
+            bars.insert(bars.end(), fresh.begin(), fresh.end());
+            writes[symbol] = { bars };
+            store(history[symbol], bars);
+        }
+
+        check(write(db, writes), "Delta sync " + std::to_string(round) + " failed");
+        compare(db, history, "delta sync " + std::to_string(round));
+        day += newDays;
+    }
+
+    // Bars older than anything stored, more stored bars follow them so they have to be read back
+    {
+        std::vector<BarData> older = market.days(-40, -1);
+
+        store(history["AAA"], older);
+        check(write(db, { { "AAA", { older } } }), "Writing older bars failed");
+        compare(db, history, "older bars");
+    }
+
+    // Bars written into the middle of the history
+    {
+        std::vector<BarData> middle = market.days(30, 45);
+
+        store(history["BBB"], middle);
+        check(write(db, { { "BBB", { middle } } }), "Rewriting the middle failed");
+        compare(db, history, "middle rewrite");
+    }
+
+    // Adjusted history, deleted and written again in the same transaction
+    {
+        std::vector<BarData> adjusted = market.days(0, day - 1);
+
+        history["CCC"] = adjusted;
+        check(write(db, { { "CCC", { adjusted } } }, { "CCC" }), "Delete and rewrite failed");
+        compare(db, history, "delete and rewrite");
+    }
+
+    // Deleted without new bars, the rollups go with them
+    {
+        history.erase("DDD");
+        check(write(db, {}, { "DDD" }), "Delete failed");
+        compare(db, history, "delete");
+    }
+
+    // Several writes of one symbol in a transaction, with duplicate timestamps between and within them
+    {
+        std::vector<BarData> first = market.days(day, day + 3);
+        std::vector<BarData> second = market.days(day + 2, day + 8);
+
+        second.push_back(market.bar(day + 8));
+        second.push_back(second.front());
+        store(history["AAA"], first);
+        store(history["AAA"], second);
+        check(write(db, { { "AAA", { first, second } } }), "Repeated writes failed");
+        compare(db, history, "repeated writes");
+        day += 9;
+    }
+
+    // A rolled back transaction leaves the rollups as they were
+    {
+        CacheWriter writer(db);
+
+        check(writer.prepare() && writer.nextSymbol() && writer.writeBars("BBB", market.days(day, day + 5)), "Writing before a rollback failed");
+        writer.rollback();
+        compare(db, history, "rollback");
+    }
+
+    // Many symbols over several transactions of one writer
+    {
+        std::map<std::string, std::vector<std::vector<BarData>>> writes;
+
+        for (int i = 0; i < CacheWriter::symbolsPerTransaction + 20; ++i) {
+            std::string symbol = "S" + std::to_string(i);
+
+            writes[symbol] = { market.days(day - 20, day - 1) };
+            store(history[symbol], writes[symbol].front());
+        }
+
+        check(write(db, writes), "Writing many symbols failed");
+        compare(db, history, "many symbols");
+    }
+
+    // Rollups lost from a cache are rebuilt by a backfill
+    {
+        QSqlQuery query(db);
+        RollupCache rollups(db);
+
+        query.exec("DELETE FROM bar_rollups WHERE symbol IN ('BBB', 'S7')");
+        check(rollups.prepare() && rollups.backfill(), "Backfill failed: " + rollups.lastError().toStdString());
+        compare(db, history, "backfill");
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d mismatches\n", failures);
+
+        return 1;
+    }
+
+    std::printf("bar_rollups matches the aggregated history\n");
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "Analysis/PriceValidator.h"
+#include "Database/BarArchive.h"
+#include "Database/CacheDatabase.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <iostream>
+#include <limits>
+
+namespace {
+    // Accepts Unix seconds or an ISO 8601 date, returns false if the text is neither
+    bool parseTime(const QString& text, qint64& timestamp) {
+        bool isNumber = false;
+        qint64 seconds = text.toLongLong(&isNumber);
+
+        if (isNumber) {
+            timestamp = seconds;
+
+            return true;
+        }
+
+        QDateTime parsed = QDateTime::fromString(text, Qt::ISODate);
+
+        if (!parsed.isValid())
+            return false;
+
+        parsed.setTimeSpec(Qt::UTC);
+        timestamp = parsed.toSecsSinceEpoch();
+
+        return true;
+    }
+
+    QString formatTime(qint64 timestamp) {
+        return QDateTime::fromSecsSinceEpoch(timestamp, Qt::UTC).toString(Qt::ISODate);
+    }
+}
+
+// Moves daily bars between the SQLite cache and a memory-mapped bar archive, or summarizes an archive
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    QCoreApplication::setApplicationName("stockhound-archive");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Import bars from the cache into a binary bar archive, export them back, or list an archive.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("command", "import, export or info.");
+
+    QCommandLineOption databaseOption({"d", "db"}, "Path to the SQLite cache.", "path", CacheDatabase::defaultPath());
+    QCommandLineOption archiveOption({"a", "archive"}, "Archive directory, defaults to archive/ next to the cache.", "path");
+    QCommandLineOption sinceOption("since", "Only bars at or after this time, Unix seconds or an ISO 8601 date.", "time");
+    QCommandLineOption untilOption("until", "Only bars at or before this time, Unix seconds or an ISO 8601 date.", "time");
+
+    parser.addOptions({ databaseOption, archiveOption, sinceOption, untilOption });
+    parser.process(application);
+
+    const QStringList arguments = parser.positionalArguments();
+    const QString command = arguments.isEmpty() ? QString() : arguments.first();
+
+    if (command != "import" && command != "export" && command != "info") {
+        std::cerr << "Please pass one of import, export or info." << std::endl;
+
+        return 1;
+    }
+
+    qint64 since = 0;
+    qint64 until = std::numeric_limits<qint64>::max();
+
+    if ((parser.isSet(sinceOption) && !parseTime(parser.value(sinceOption), since)) ||
+        (parser.isSet(untilOption) && !parseTime(parser.value(untilOption), until))) {
+        std::cerr << "Times must be Unix seconds or ISO 8601 dates." << std::endl;
+
+        return 1;
+    }
+
+    const QString databasePath = parser.value(databaseOption);
+    const QString archivePath = parser.isSet(archiveOption) ? parser.value(archiveOption) : QFileInfo(databasePath).absoluteDir().filePath("archive");
+    BarArchive archive(archivePath);
+
+    if (!archive.open()) {
+        std::cerr << archive.lastError().toStdString() << std::endl;
+
+        return 2;
+    }
+
+    if (command == "info") {
+        qint64 totalBars = 0;
+
+        for (const BarArchiveEntry& entry : archive.entries()) {
+            std::cout << entry.Symbol << '\t' << entry.Count << '\t' << formatTime(entry.FirstTimestamp).toStdString() << '\t'
+                      << formatTime(entry.LastTimestamp).toStdString() << std::endl;
+            totalBars += entry.Count;
+        }
+
+        std::cerr << archive.entries().size() << " symbols, " << totalBars << " bars in " << archivePath.toStdString() << std::endl;
+
+        // Opening may have re-scanned data files, the index picks those up here
+        if (!archive.close()) {
+            std::cerr << "Closing the archive failed: " << archive.lastError().toStdString() << std::endl;
+
+            return 2;
+        }
+
+        return 0;
+    }
+
+    QSqlDatabase db;
+    QString errorMessage;
+    QElapsedTimer timer;
+
+    QStringList migrations;
+
+    if (!CacheDatabase::open(db, databasePath, QLatin1String(QSqlDatabase::defaultConnection), errorMessage, &migrations)) {
+        std::cerr << errorMessage.toStdString() << std::endl;
+
+        return 2;
+    }
+
+    for (const QString& migration : migrations)
+        std::clog << migration.toStdString() << std::endl;
+
+    timer.start();
+
+    bool succeeded = command == "import" ? archive.importFrom(db, since, until) : archive.exportTo(db, since, until);
+
+    if (!succeeded) {
+        std::cerr << "Archive " << command.toStdString() << " failed: " << archive.lastError().toStdString() << std::endl;
+
+        return 2;
+    }
+
+    std::cerr << (command == "import" ? "Archived " : "Exported ") << archive.barsWritten() << " bars in " << timer.elapsed() << " ms." << std::endl;
+
+    // Exported bars can move the latest close under cached prices and scores, reconcile them like a scan would
+    if (command == "export" && archive.barsWritten() > 0) {
+        PriceValidator validator(db);
+
+        if (!validator.run()) {
+            std::cerr << "Cache validation failed: " << validator.lastError().toStdString() << std::endl;
+
+            return 2;
+        }
+
+        const PriceValidationStats& stats = validator.stats();
+
+        std::cerr << "Validated cache: " << stats.PricesCorrected << " prices corrected, " << stats.ScoresUpdated << " of " << stats.ScoresChecked
+                  << " suspicious scores updated, " << stats.SymbolsExcluded << " symbols excluded." << std::endl;
+    }
+
+    if (!archive.close()) {
+        std::cerr << "Closing the archive failed: " << archive.lastError().toStdString() << std::endl;
+
+        return 2;
+    }
+
+    return 0;
+}
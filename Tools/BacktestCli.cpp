@@ -0,0 +1,211 @@
+#include "Analysis/Backtester.h"
+#include "Analysis/PriceStore.h"
+#include "Database/BarArchive.h"
+#include "Database/CacheDatabase.h"
+#include "Database/RollupCache.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace {
+    // Accepts Unix seconds or an ISO 8601 date, returns false if the text is neither
+    bool parseTime(const QString& text, qint64& timestamp) {
+        bool isNumber = false;
+        qint64 seconds = text.toLongLong(&isNumber);
+
+        if (isNumber) {
+            timestamp = seconds;
+
+            return true;
+        }
+
+        QDateTime parsed = QDateTime::fromString(text, Qt::ISODate);
+
+        if (!parsed.isValid())
+            return false;
+
+        parsed.setTimeSpec(Qt::UTC);
+        timestamp = parsed.toSecsSinceEpoch();
+
+        return true;
+    }
+
+    std::string formatTime(qint64 timestamp) {
+        return QDateTime::fromSecsSinceEpoch(timestamp, Qt::UTC).toString(Qt::ISODate).toStdString();
+    }
+
+    void writeTrades(std::ostream& out, const PriceStore& store, const std::vector<BacktestTrade>& trades) {
+        out << "Symbol,Entry,Exit,EntryPrice,ExitPrice,Shares,Score,Return,Profit\n";
+
+        for (const BacktestTrade& trade : trades) {
+            out << store.symbol(trade.SymbolIndex) << ',' << formatTime(trade.EntryTimestamp) << ',' << formatTime(trade.ExitTimestamp) << ','
+                << trade.EntryPrice << ',' << trade.ExitPrice << ',' << trade.Shares << ',' << trade.EntryScore << ','
+                << trade.Return << ',' << trade.Profit << '\n';
+        }
+    }
+}
+
+// Replays the scoring model over stored history and reports how its signals would have traded
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    QCoreApplication::setApplicationName("stockhound-backtest");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Backtest the StockHound score over the cached or archived price history.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption databaseOption({"d", "db"}, "Path to the SQLite cache.", "path", CacheDatabase::defaultPath());
+    QCommandLineOption archiveOption({"a", "archive"}, "Read bars from this archive directory instead of the cache.", "path");
+    QCommandLineOption budgetOption({"b", "budget"}, "Capital per trade, entries above it are skipped. 0 trades one share.", "amount", "0");
+    QCommandLineOption entryScoreOption("entry-score", "Enter after a close scoring at least this.", "score", "0.8");
+    QCommandLineOption exitScoreOption("exit-score", "Exit once the score falls below this, 0 disables.", "score", "0");
+    QCommandLineOption holdOption("hold", "Exit this many bars after entry at the latest.", "bars", "10");
+    QCommandLineOption takeProfitOption("take-profit", "Exit once a close gains this fraction, 0 disables.", "fraction", "0.10");
+    QCommandLineOption stopLossOption("stop-loss", "Exit once a close loses this fraction, 0 disables.", "fraction", "0.05");
+    QCommandLineOption windowOption("window", "Closes per scoring window, raised to what the weighted indicators need.", "bars", "28");
+    QCommandLineOption maxScoreOption("max-score", "Ignore signals whose total score reaches this value.", "score", "1.1");
+    QCommandLineOption sinceOption("since", "Only enter at or after this time, Unix seconds or an ISO 8601 date.", "time");
+    QCommandLineOption untilOption("until", "Only enter at or before this time, Unix seconds or an ISO 8601 date.", "time");
+    QCommandLineOption threadsOption("threads", "Threads used for the backtest, 0 for every core.", "count", "0");
+    QCommandLineOption tradesOption("trades", "Write every simulated trade as CSV to this file.", "path");
+    QCommandLineOption timeframeOption("timeframe", "Bars to score and trade on, 1Day, 1Week or 1Month.", "timeframe", "1Day");
+    QCommandLineOption weightsOption("weights", "Indicator weights of the total score, e.g. ma=0.4,rsi=0.3,bb=0.3,macd=0.1. Defaults to STOCKHOUND_WEIGHTS.", "weights");
+
+    parser.addOptions({ databaseOption, archiveOption, budgetOption, entryScoreOption, exitScoreOption, holdOption, takeProfitOption,
+                        stopLossOption, windowOption, maxScoreOption, sinceOption, untilOption, threadsOption, tradesOption, timeframeOption,
+                        weightsOption });
+    parser.process(application);
+
+    BacktestOptions options;
+
+    options.budget = std::max(0.0, parser.value(budgetOption).toDouble());
+    options.entryScore = parser.value(entryScoreOption).toDouble();
+    options.exitScore = parser.value(exitScoreOption).toDouble();
+    options.maxHoldBars = parser.value(holdOption).toInt();
+    options.takeProfit = parser.value(takeProfitOption).toDouble();
+    options.stopLoss = parser.value(stopLossOption).toDouble();
+    options.windowBars = parser.value(windowOption).toInt();
+    options.scoreCeiling = parser.value(maxScoreOption).toDouble();
+    std::string weightsError;
+
+    if (!ScoreWeights::fromEnvironment(options.weights, weightsError))
+        std::cerr << weightsError << std::endl;
+
+    if (parser.isSet(weightsOption) && !ScoreWeights::parse(parser.value(weightsOption).toStdString(), options.weights, weightsError)) {
+        std::cerr << "Invalid --weights: " << weightsError << std::endl;
+
+        return 1;
+    }
+
+    Timeframe timeframe;
+
+    if (!BarAggregator::parseTimeframe(parser.value(timeframeOption).toStdString(), timeframe) || timeframe < Timeframe::Day) {
+        std::cerr << "Invalid --timeframe: the cache holds 1Day bars and their 1Week and 1Month rollups." << std::endl;
+
+        return 1;
+    }
+
+    if ((parser.isSet(sinceOption) && !parseTime(parser.value(sinceOption), options.since)) ||
+        (parser.isSet(untilOption) && !parseTime(parser.value(untilOption), options.until))) {
+        std::cerr << "Times must be Unix seconds or ISO 8601 dates." << std::endl;
+
+        return 1;
+    }
+
+    PriceStore store;
+    QElapsedTimer timer;
+
+    timer.start();
+
+    if (parser.isSet(archiveOption)) {
+        BarArchive archive(parser.value(archiveOption));
+
+        if (!archive.open() || !archive.loadInto(store)) {
+            std::cerr << archive.lastError().toStdString() << std::endl;
+
+            return 2;
+        }
+
+        // Archives only hold daily bars, coarser ones are rolled up in memory
+        if (timeframe != Timeframe::Day) {
+            PriceStore daily = std::move(store);
+
+            store.rollUp(daily, timeframe);
+        }
+    } else {
+        QSqlDatabase db;
+        QString errorMessage;
+
+        QStringList migrations;
+
+        if (!CacheDatabase::open(db, parser.value(databaseOption), QLatin1String(QSqlDatabase::defaultConnection), errorMessage, &migrations)) {
+            std::cerr << errorMessage.toStdString() << std::endl;
+
+            return 2;
+        }
+
+        for (const QString& migration : migrations)
+            std::clog << migration.toStdString() << std::endl;
+
+        // Caches written before rollups existed get them on first use
+        RollupCache rollups(db);
+
+        if (timeframe != Timeframe::Day && (!rollups.prepare() || !rollups.backfill())) {
+            std::cerr << rollups.lastError().toStdString() << std::endl;
+
+            return 2;
+        }
+
+        if (!store.loadRollups(db, timeframe, errorMessage)) {
+            std::cerr << errorMessage.toStdString() << std::endl;
+
+            return 2;
+        }
+    }
+
+    std::cerr << "Loaded " << store.barCount() << " " << BarAggregator::timeframeName(timeframe) << " bars of " << store.symbolCount() << " symbols in "
+              << timer.elapsed() << " ms." << std::endl;
+
+    Backtester backtester(static_cast<unsigned>(std::max(0, parser.value(threadsOption).toInt())));
+    BacktestReport report = backtester.run(store, options);
+
+    std::printf("Symbols       %zu\n", report.Symbols);
+    std::printf("Bars scored   %zu\n", report.BarsScored);
+    std::printf("Trades        %zu\n", report.Trades);
+    std::printf("Hit rate      %.1f%%\n", report.HitRate * 100.0);
+    std::printf("Mean return   %.2f%%\n", report.MeanReturn * 100.0);
+    std::printf("Total profit  %.2f\n", report.TotalProfit);
+    std::printf("Max drawdown  %.2f\n", report.MaxDrawdown);
+    std::printf("\nScore   Bars      Fwd return  Hit rate   (%d bars ahead)\n", std::max(1, options.maxHoldBars));
+
+    for (const ScoreBucket& bucket : report.Buckets)
+        std::printf("%.1f%s    %-9zu %+7.2f%%    %5.1f%%\n", bucket.LowerBound, bucket.LowerBound < 0.85 ? " " : "+", bucket.Bars,
+                    bucket.MeanForwardReturn * 100.0, bucket.HitRate * 100.0);
+
+    if (parser.isSet(tradesOption)) {
+        std::ofstream file(parser.value(tradesOption).toStdString());
+
+        if (!file) {
+            std::cerr << "Failed to open trades file: " << parser.value(tradesOption).toStdString() << std::endl;
+
+            return 2;
+        }
+
+        writeTrades(file, store, report.TradeList);
+    }
+
+    std::cerr << "Backtested on " << report.Threads << " threads over " << report.Segments << " segments in " << report.ElapsedMs << " ms." << std::endl;
+
+    return 0;
+}
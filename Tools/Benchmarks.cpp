@@ -0,0 +1,517 @@
+#include "Analysis/IndicatorKernels.h"
+#include "Analysis/IndicatorPipeline.h"
+#include "Analysis/IndicatorState.h"
+#include "Analysis/ParallelScorer.h"
+#include "Analysis/PriceStore.h"
+#include "Analysis/StockAnalysis.h"
+#include "Database/CacheDatabase.h"
+#include "Database/CacheWriter.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Micro and macro benchmarks for the scoring math and the SQLite path, with JSON output for tracking regressions.
+// Every benchmark runs on synthetic data from a fixed seed, so runs on the same machine are comparable.
+
+namespace {
+    struct BenchmarkResult {
+        std::string Name;
+        std::size_t Iterations = 0;      // Per repetition
+        std::size_t Items = 0;           // Work items per iteration, bars or symbols
+        double MinNs = 0.0;              // Best repetition, nanoseconds per iteration
+        double MedianNs = 0.0;
+        double ItemsPerSecond = 0.0;     // From the best repetition
+    };
+
+    struct BenchmarkOptions {
+        double minTimeMs = 200.0;        // Each repetition runs at least this long
+        int repetitions = 5;
+        QString filter;
+    };
+
+    // Keeps results alive so the optimizer cannot drop the measured work
+    volatile double sink = 0.0;
+
+    void consume(const Indicators& indicators) {
+        sink = sink + indicators.MovingAverage + indicators.RSI;
+    }
+
+    void consume(double value) {
+        sink = sink + value;
+    }
+
+    class BenchmarkRunner {
+    public:
+        explicit BenchmarkRunner(const BenchmarkOptions& benchmarkOptions) : options(benchmarkOptions) {}
+
+        bool selected(const std::string& name) const {
+            return options.filter.isEmpty() || QString::fromStdString(name).contains(options.filter);
+        }
+
+        // Calls body repeatedly, the iteration count is calibrated so one repetition takes minTimeMs
+        void run(const std::string& name, std::size_t items, const std::function<void()>& body) {
+            if (!selected(name))
+                return;
+
+            std::size_t iterations = 1;
+
+            for (;;) {
+                double elapsedMs = measure(iterations, body) / 1e6;
+
+                if (elapsedMs >= options.minTimeMs / 10.0 || iterations >= (std::size_t(1) << 30)) {
+                    iterations = std::max<std::size_t>(1, static_cast<std::size_t>(iterations * options.minTimeMs / std::max(elapsedMs, 1e-3)));
+                    break;
+                }
+
+                iterations *= 10;
+            }
+
+            std::vector<double> samples;
+
+            for (int i = 0; i < options.repetitions; ++i)
+                samples.push_back(measure(iterations, body) / static_cast<double>(iterations));
+
+            record(name, iterations, items, samples);
+        }
+
+        // For macro benchmarks with their own setup, body returns the nanoseconds of the measured part of one run
+        void runTimed(const std::string& name, std::size_t items, const std::function<double()>& body) {
+            if (!selected(name))
+                return;
+
+            std::vector<double> samples;
+
+            for (int i = 0; i < options.repetitions; ++i)
+                samples.push_back(body());
+
+            record(name, 1, items, samples);
+        }
+
+        const std::vector<BenchmarkResult>& results() const {
+            return benchmarkResults;
+        }
+
+    private:
+        BenchmarkOptions options;
+        std::vector<BenchmarkResult> benchmarkResults;
+
+        static double measure(std::size_t iterations, const std::function<void()>& body) {
+            auto start = std::chrono::steady_clock::now();
+
+            for (std::size_t i = 0; i < iterations; ++i)
+                body();
+
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void record(const std::string& name, std::size_t iterations, std::size_t items, std::vector<double> samples) {
+            BenchmarkResult result;
+
+            std::sort(samples.begin(), samples.end());
+
+            result.Name = name;
+            result.Iterations = iterations;
+            result.Items = items;
+            result.MinNs = samples.front();
+            result.MedianNs = samples[samples.size() / 2];
+            result.ItemsPerSecond = result.MinNs > 0 ? static_cast<double>(items) * 1e9 / result.MinNs : 0.0;
+
+            std::printf("%-48s %14.1f ns %14.1f ns %16.0f items/s\n", name.c_str(), result.MinNs, result.MedianNs, result.ItemsPerSecond);
+            std::fflush(stdout);
+
+            benchmarkResults.push_back(result);
+        }
+    };
+
+    // Geometric random walk with daily bars, the same shape of data a scan stores
+    std::vector<BarData> randomWalk(std::mt19937_64& random, std::size_t count, qint64 firstTimestamp) {
+        std::normal_distribution<double> change(0.0, 0.02);
+        std::uniform_real_distribution<double> start(2.0, 200.0);
+        std::vector<BarData> bars;
+        double close = start(random);
+
+        bars.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            double open = close;
+
+            close = std::max(0.01, close * (1.0 + change(random)));
+            bars.push_back({ firstTimestamp + static_cast<qint64>(i) * 86400, open, std::max(open, close) * 1.005, std::min(open, close) * 0.995, close,
+                             static_cast<qint64>(100000 + random() % 900000) });
+        }
+
+        return bars;
+    }
+
+    std::vector<double> closesOf(const std::vector<BarData>& bars) {
+        std::vector<double> closes;
+
+        closes.reserve(bars.size());
+
+        for (const BarData& bar : bars)
+            closes.push_back(bar.Close);
+
+        return closes;
+    }
+
+    std::string symbolName(std::size_t index) {
+        char name[32];
+
+        std::snprintf(name, sizeof(name), "SYN%05zu", index);
+
+        return name;
+    }
+
+    void fillStore(PriceStore& store, std::mt19937_64& random, std::size_t symbols, std::size_t barsPerSymbol) {
+        store.clear();
+        store.reserve(symbols, symbols * barsPerSymbol);
+
+        for (std::size_t i = 0; i < symbols; ++i)
+            store.append(symbolName(i), randomWalk(random, barsPerSymbol, 1700000000));
+    }
+
+    std::vector<SimdLevel> supportedLevels() {
+        std::vector<SimdLevel> levels{ SimdLevel::Scalar };
+
+        if (IndicatorKernels::activeLevel() >= SimdLevel::SSE2)
+            levels.push_back(SimdLevel::SSE2);
+
+        if (IndicatorKernels::activeLevel() >= SimdLevel::AVX2)
+            levels.push_back(SimdLevel::AVX2);
+
+        return levels;
+    }
+
+    void indicatorBenchmarks(BenchmarkRunner& runner, std::mt19937_64& random, bool quick) {
+        const std::vector<std::size_t> windows = quick ? std::vector<std::size_t>{ 30, 250 } : std::vector<std::size_t>{ 14, 30, 100, 250, 1000 };
+        ScoreWeights allIndicators;
+        std::string weightsError;
+
+        ScoreWeights::parse("ma=1,rsi=1,bb=1,ema=1,macd=1,atr=1,vwap=1,volume=1", allIndicators, weightsError);
+
+        for (std::size_t window : windows) {
+            const std::vector<BarData> bars = randomWalk(random, window, 0);
+            const std::vector<double> closes = closesOf(bars);
+            const std::string suffix = "/window:" + std::to_string(window);
+
+            for (SimdLevel level : supportedLevels()) {
+                runner.run(std::string("indicators/") + IndicatorKernels::levelName(level) + suffix, window, [&]() {
+                    consume(IndicatorKernels::compute(closes, 0, level));
+                });
+            }
+
+            runner.run("score/series" + suffix, window, [&]() {
+                consume(StockAnalysis::calculateTotalScores(closes.back(), closes, static_cast<int>(window)).Total_Score);
+            });
+
+            // Every indicator weighted, the single OHLCV pass a scan takes once weights go beyond MA, RSI and BB
+            PriceStore barStore;
+            barStore.append("PIPE", bars);
+
+            runner.run("score/pipeline" + suffix, window, [&]() {
+                consume(StockAnalysis::calculateTotalScores(closes.back(), barStore.series(0), allIndicators).Total_Score);
+            });
+        }
+
+        const std::vector<double> closes = closesOf(randomWalk(random, 30, 0));
+        const Indicators indicators = IndicatorKernels::compute(closes, 0);
+
+        runner.run("score/indicators", 1, [&]() {
+            consume(StockAnalysis::calculateTotalScores(closes.back(), indicators).Total_Score);
+        });
+
+        // One bar in, one bar out, the live and backtest update path
+        const std::vector<double> walk = closesOf(randomWalk(random, 100000, 0));
+        const std::size_t window = 30;
+        IndicatorState state = IndicatorState::fromSeries(std::span<const double>(walk.data(), window), 0);
+        std::size_t next = window;
+
+        runner.run("state/slide", 1, [&]() {
+            if (next == walk.size()) {
+                state = IndicatorState::fromSeries(std::span<const double>(walk.data(), window), 0);
+                next = window;
+            }
+
+            state.slide(walk[next - window], walk[next - window + 1], walk[next], 0);
+            consume(StockAnalysis::calculateTotalScores(walk[next], state.indicators()).Total_Score);
+            ++next;
+        });
+    }
+
+    void universeBenchmarks(BenchmarkRunner& runner, std::mt19937_64& random, bool quick) {
+        const std::vector<std::size_t> universes = quick ? std::vector<std::size_t>{ 1000 } : std::vector<std::size_t>{ 1000, 10000, 50000 };
+        PriceStore store;
+        std::vector<Indicators> indicators;
+        std::vector<ScoreCard> scores;
+
+        for (std::size_t symbols : universes) {
+            const std::string suffix = "/symbols:" + std::to_string(symbols);
+
+            fillStore(store, random, symbols, 28);
+
+            std::vector<double> prices(symbols);
+
+            for (std::size_t i = 0; i < symbols; ++i)
+                prices[i] = store.closes(i).back();
+
+            indicators.resize(symbols);
+
+            for (SimdLevel level : supportedLevels()) {
+                runner.run(std::string("universe/indicators/") + IndicatorKernels::levelName(level) + suffix, symbols, [&]() {
+                    for (std::size_t i = 0; i < symbols; ++i)
+                        indicators[i] = IndicatorKernels::compute(store.closes(i), 0, level);
+
+                    consume(indicators.back());
+                });
+            }
+
+            ParallelScorer sequential(1);
+            ParallelScorer parallel;
+
+            runner.run("universe/score/threads:1" + suffix, symbols, [&]() {
+                sequential.score(store, prices, scores);
+                consume(scores.back().Total_Score);
+            });
+
+            if (parallel.threadCount() > 1) {
+                runner.run("universe/score/threads:" + std::to_string(parallel.threadCount()) + suffix, symbols, [&]() {
+                    parallel.score(store, prices, scores);
+                    consume(scores.back().Total_Score);
+                });
+            }
+        }
+    }
+
+    // Bulk ingest and the offline part of a scan, each repetition on a fresh cache
+    bool databaseBenchmarks(BenchmarkRunner& runner, std::mt19937_64& random, bool quick) {
+        QTemporaryDir directory;
+
+        if (!directory.isValid()) {
+            std::cerr << "Failed to create a temporary directory for the cache benchmarks" << std::endl;
+
+            return false;
+        }
+
+        const std::vector<std::size_t> universes = quick ? std::vector<std::size_t>{ 1000 } : std::vector<std::size_t>{ 1000, 10000 };
+        const std::size_t barsPerSymbol = 28;
+        int run = 0;
+        bool succeeded = true;
+
+        for (std::size_t symbols : universes) {
+            std::vector<std::vector<BarData>> universe;
+
+            for (std::size_t i = 0; i < symbols; ++i)
+                universe.push_back(randomWalk(random, barsPerSymbol, 1700000000));
+
+            // Opens a fresh cache, the connection is removed again when the run ends
+            auto withCache = [&](const std::function<double(QSqlDatabase&)>& body) {
+                const QString connection = QString("bench-%1").arg(run);
+                const QString path = directory.filePath(QString("cache-%1.db").arg(run++));
+                double elapsedNs = 0.0;
+
+                {
+                    QSqlDatabase db;
+                    QString errorMessage;
+
+                    if (CacheDatabase::open(db, path, connection, errorMessage)) {
+                        elapsedNs = body(db);
+                    } else {
+                        std::cerr << errorMessage.toStdString() << std::endl;
+                        succeeded = false;
+                    }
+
+                    db.close();
+                }
+
+                QSqlDatabase::removeDatabase(connection);
+
+                return elapsedNs;
+            };
+
+            auto ingest = [&](QSqlDatabase& db) {
+                CacheWriter writer(db);
+                qint64 now = QDateTime::currentSecsSinceEpoch();
+
+                if (!writer.prepare())
+                    return false;
+
+                for (std::size_t i = 0; i < symbols; ++i) {
+                    const std::string symbol = symbolName(i);
+
+                    if (!writer.nextSymbol() || !writer.writeStock(symbol, symbol, symbol, now) ||
+                        !writer.writeTrade(symbol, universe[i].back().Close, 100) || !writer.writeBars(symbol, universe[i]))
+                        return false;
+                }
+
+                return writer.commit();
+            };
+
+            const std::string suffix = "/symbols:" + std::to_string(symbols);
+
+            runner.runTimed("cache/ingest" + suffix, symbols * barsPerSymbol, [&]() {
+                return withCache([&](QSqlDatabase& db) {
+                    auto start = std::chrono::steady_clock::now();
+
+                    if (!ingest(db))
+                        succeeded = false;
+
+                    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                });
+            });
+
+            // What a scan does once the bars are cached: load the window, score on every core, write results back
+            runner.runTimed("scan/offline" + suffix, symbols, [&]() {
+                return withCache([&](QSqlDatabase& db) {
+                    if (!ingest(db)) {
+                        succeeded = false;
+
+                        return 0.0;
+                    }
+
+                    auto start = std::chrono::steady_clock::now();
+                    PriceStore store;
+                    ParallelScorer scorer;
+                    CacheWriter writer(db);
+                    std::vector<ScoreCard> scores;
+                    std::vector<double> prices;
+                    QString errorMessage;
+
+                    if (!store.load(db, errorMessage) || !writer.prepare()) {
+                        succeeded = false;
+
+                        return 0.0;
+                    }
+
+                    for (std::size_t i = 0; i < store.symbolCount(); ++i)
+                        prices.push_back(store.closes(i).back());
+
+                    scorer.score(store, prices, scores);
+
+                    for (std::size_t i = 0; i < store.symbolCount(); ++i) {
+                        const ScoreCard& card = scores[i];
+                        const std::span<const qint64> timestamps = store.timestamps(i);
+
+                        if (!writer.nextSymbol() ||
+                            !writer.writeScores(store.symbol(i), card.MA_Score, card.RSI_Score, card.BB_Score, card.Total_Score) ||
+                            !writer.writeIndicatorState(store.symbol(i), IndicatorState::fromSeries(store.closes(i), timestamps.back()))) {
+                            succeeded = false;
+
+                            return 0.0;
+                        }
+                    }
+
+                    if (!writer.commit() || !writer.excludeScoresAtOrAbove(1.1))
+                        succeeded = false;
+
+                    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                });
+            });
+        }
+
+        return succeeded;
+    }
+
+    nlohmann::json toJson(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options) {
+        nlohmann::json benchmarks = nlohmann::json::array();
+
+        for (const BenchmarkResult& result : results) {
+            benchmarks.push_back({
+                { "name", result.Name },
+                { "iterations", result.Iterations },
+                { "items", result.Items },
+                { "min_ns", result.MinNs },
+                { "median_ns", result.MedianNs },
+                { "items_per_second", result.ItemsPerSecond }
+            });
+        }
+
+        return {
+            { "context", {
+                { "date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toStdString() },
+                { "simd", IndicatorKernels::levelName(IndicatorKernels::activeLevel()) },
+                { "hardware_threads", std::thread::hardware_concurrency() },
+                { "repetitions", options.repetitions },
+                { "min_time_ms", options.minTimeMs }
+            } },
+            { "benchmarks", benchmarks }
+        };
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    QCoreApplication::setApplicationName("stockhound_bench");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Benchmark the indicator kernels, scoring, cache ingest and the offline scan path.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text.", "text");
+    QCommandLineOption jsonOption("json", "Write the results as JSON to this file.", "path");
+    QCommandLineOption repetitionsOption("repetitions", "Repetitions per benchmark, the best and the median are reported.", "count", "5");
+    QCommandLineOption minTimeOption("min-time", "Milliseconds each repetition of a micro benchmark runs at least.", "ms", "200");
+    QCommandLineOption quickOption("quick", "Fewer sizes and a shorter minimum time, for smoke runs.");
+    QCommandLineOption seedOption("seed", "Seed of the synthetic data.", "seed", "1");
+
+    parser.addOptions({ filterOption, jsonOption, repetitionsOption, minTimeOption, quickOption, seedOption });
+    parser.process(application);
+
+    BenchmarkOptions options;
+    const bool quick = parser.isSet(quickOption);
+
+    options.filter = parser.value(filterOption);
+    options.repetitions = std::max(1, parser.value(repetitionsOption).toInt());
+    options.minTimeMs = std::max(1.0, parser.value(minTimeOption).toDouble());
+
+    if (quick) {
+        options.repetitions = std::min(options.repetitions, 3);
+        options.minTimeMs = std::min(options.minTimeMs, 50.0);
+    }
+
+    std::mt19937_64 random(parser.value(seedOption).toULongLong());
+    BenchmarkRunner runner(options);
+
+    std::printf("%-48s %17s %17s %24s\n", "Benchmark", "Best", "Median", "Throughput");
+
+    indicatorBenchmarks(runner, random, quick);
+    universeBenchmarks(runner, random, quick);
+
+    if (!databaseBenchmarks(runner, random, quick)) {
+        std::cerr << "Cache benchmarks failed" << std::endl;
+
+        return 2;
+    }
+
+    if (parser.isSet(jsonOption)) {
+        std::ofstream file(parser.value(jsonOption).toStdString());
+
+        if (!file) {
+            std::cerr << "Failed to open output file: " << parser.value(jsonOption).toStdString() << std::endl;
+
+            return 2;
+        }
+
+        file << toJson(runner.results(), options).dump(2) << std::endl;
+    }
+
+    return 0;
+}
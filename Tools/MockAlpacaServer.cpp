@@ -0,0 +1,421 @@
+#include "SyntheticMarket.h"
+
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Local stand-in for the Alpaca trading and data endpoints used by a scan, so the pipeline can run offline.
+// Point APCA_API_BASE_URL and APCA_API_DATA_URL, or stockhound-scan --api-url, at the address this server listens on.
+
+namespace {
+    // Howard Hinnant's days_from_civil, converts a calendar date to days since 1970-01-01
+    std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+
+        const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+        const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+        return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+    }
+
+    // Parses "YYYY-MM-DDTHH:MM:SSZ" (the time part is optional), returns -1 if malformed
+    std::int64_t parseTimestamp(const std::string& text) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+
+        if (std::sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) < 3)
+            return -1;
+
+        return daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 + hour * 3600 + minute * 60 + second;
+    }
+
+    std::string formatTimestamp(std::int64_t timestamp) {
+        std::time_t seconds = static_cast<std::time_t>(timestamp);
+        std::tm utc{};
+        char buffer[32];
+
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+        return buffer;
+    }
+
+    std::vector<std::string> splitSymbols(const std::string& list) {
+        std::vector<std::string> symbols;
+        std::stringstream stream(list);
+        std::string symbol;
+
+        while (std::getline(stream, symbol, ','))
+            if (!symbol.empty())
+                symbols.push_back(symbol);
+
+        return symbols;
+    }
+
+    nlohmann::json assetToJson(const SyntheticAsset& asset, const std::string& exchange) {
+        return {
+            {"id", asset.Id},
+            {"class", "us_equity"},
+            {"exchange", exchange},
+            {"symbol", asset.Symbol},
+            {"name", asset.Name},
+            {"status", "active"},
+            {"tradable", asset.Tradable},
+            {"marginable", true},
+            {"shortable", false},
+            {"easy_to_borrow", false},
+            {"fractionable", false}
+        };
+    }
+
+    nlohmann::json barToJson(const SyntheticBar& bar) {
+        return {
+            {"t", formatTimestamp(bar.Timestamp)},
+            {"o", bar.Open},
+            {"h", bar.High},
+            {"l", bar.Low},
+            {"c", bar.Close},
+            {"v", bar.Volume},
+            {"n", bar.TradeCount},
+            {"vw", bar.Vwap}
+        };
+    }
+
+    // Delays and failures injected in front of every API route
+    struct FaultOptions {
+        int latencyMs = 0;
+        int latencyJitterMs = 0;
+        double errorRate = 0.0;      // Share of requests answered with a 500 or 503
+        double throttleRate = 0.0;   // Share of requests answered with a 429
+        int rateLimit = 0;           // Requests per minute before every further request gets a 429, 0 disables
+    };
+
+    class FaultInjector {
+    public:
+        explicit FaultInjector(const FaultOptions& faultOptions) : options(faultOptions), random(std::random_device{}()) {}
+
+        // Returns true if the request was answered with an injected error
+        bool apply(httplib::Response& res) {
+            int delay = options.latencyMs;
+            double roll = 0.0;
+            bool overLimit = false;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (options.latencyJitterMs > 0)
+                    delay += std::uniform_int_distribution<int>(0, options.latencyJitterMs)(random);
+
+                roll = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+
+                if (options.rateLimit > 0) {
+                    auto now = std::chrono::steady_clock::now();
+
+                    while (!window.empty() && now - window.front() >= std::chrono::minutes(1))
+                        window.pop_front();
+
+                    overLimit = window.size() >= static_cast<std::size_t>(options.rateLimit);
+
+                    if (!overLimit)
+                        window.push_back(now);
+                }
+            }
+
+            if (delay > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+
+            if (overLimit || roll < options.throttleRate) {
+                res.status = 429;
+                res.set_header("Retry-After", "1");
+                res.set_content(R"({"message":"too many requests."})", "application/json");
+
+                return true;
+            }
+
+            if (roll < options.throttleRate + options.errorRate) {
+                res.status = roll < options.throttleRate + options.errorRate / 2 ? 500 : 503;
+                res.set_content(R"({"message":"internal server error"})", "application/json");
+
+                return true;
+            }
+
+            return false;
+        }
+
+    private:
+        FaultOptions options;
+        std::mutex mutex;
+        std::mt19937 random;
+        std::deque<std::chrono::steady_clock::time_point> window;
+    };
+
+    class RequestCounter {
+    public:
+        void count(const std::string& endpoint) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++counts[endpoint];
+        }
+
+        nlohmann::json toJson() {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            return nlohmann::json(counts);
+        }
+
+    private:
+        std::mutex mutex;
+        std::map<std::string, std::int64_t> counts;
+    };
+
+    void usage() {
+        std::cerr << "Usage: stockhound-mock-alpaca [--host 127.0.0.1] [--port 8089] [--symbols 500] [--days 60] [--end-date YYYY-MM-DD] [--seed 1]\n"
+                  << "                             [--exchange NYSE] [--latency-ms 0] [--latency-jitter-ms 0] [--error-rate 0.0] [--throttle-rate 0.0] [--rate-limit 0]"
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+                  << " [--cert cert.pem --key key.pem]"
+#endif
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string host = "127.0.0.1";
+    int port = 8089;
+    SyntheticMarketOptions marketOptions;
+    std::string exchange = "NYSE";
+    std::string certPath;
+    std::string keyPath;
+    FaultOptions faults;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            usage();
+
+            return 0;
+        }
+
+        if (i + 1 >= argc) {
+            usage();
+
+            return 1;
+        }
+
+        std::string value = argv[++i];
+
+        if (arg == "--host")
+            host = value;
+        else if (arg == "--port")
+            port = std::atoi(value.c_str());
+        else if (arg == "--symbols")
+            marketOptions.symbols = static_cast<std::size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (arg == "--days")
+            marketOptions.days = std::atoi(value.c_str());
+        else if (arg == "--end-date")
+            marketOptions.endDay = parseTimestamp(value) < 0 ? -1 : parseTimestamp(value) / 86400;
+        else if (arg == "--seed")
+            marketOptions.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--exchange")
+            exchange = value;
+        else if (arg == "--latency-ms")
+            faults.latencyMs = std::atoi(value.c_str());
+        else if (arg == "--latency-jitter-ms")
+            faults.latencyJitterMs = std::atoi(value.c_str());
+        else if (arg == "--error-rate")
+            faults.errorRate = std::atof(value.c_str());
+        else if (arg == "--throttle-rate")
+            faults.throttleRate = std::atof(value.c_str());
+        else if (arg == "--rate-limit")
+            faults.rateLimit = std::atoi(value.c_str());
+        else if (arg == "--cert")
+            certPath = value;
+        else if (arg == "--key")
+            keyPath = value;
+        else {
+            usage();
+
+            return 1;
+        }
+    }
+
+    if (marketOptions.endDay < 0) {
+        std::cerr << "--end-date must be YYYY-MM-DD" << std::endl;
+
+        return 1;
+    }
+
+    SyntheticMarket market(marketOptions);
+    RequestCounter counter;
+    FaultInjector injector(faults);
+
+    // The listing is the largest response and never changes, so it is serialized once
+    nlohmann::json listing = nlohmann::json::array();
+
+    for (const SyntheticAsset& asset : market.assets())
+        listing.push_back(assetToJson(asset, exchange));
+
+    const std::string listingBody = listing.dump();
+
+    listing = nlohmann::json();
+
+    // Latest trades only need an asset's last bar, which is generated once on first use
+    std::vector<std::once_flag> lastBarOnce(market.assets().size());
+    std::vector<SyntheticBar> lastBars(market.assets().size());
+
+    auto lastBar = [&](const SyntheticAsset& asset) -> const SyntheticBar& {
+        std::size_t index = static_cast<std::size_t>(&asset - market.assets().data());
+
+        std::call_once(lastBarOnce[index], [&]() { lastBars[index] = market.bars(asset).back(); });
+
+        return lastBars[index];
+    };
+
+    std::unique_ptr<httplib::Server> server;
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (!certPath.empty() && !keyPath.empty())
+        server = std::make_unique<httplib::SSLServer>(certPath.c_str(), keyPath.c_str());
+    else
+#endif
+        server = std::make_unique<httplib::Server>();
+
+    // Every API route gets the configured latency and errors, the stats route is left alone
+    server->set_pre_routing_handler([&](const httplib::Request& req, httplib::Response& res) {
+        if (req.path.rfind("/mock/", 0) == 0)
+            return httplib::Server::HandlerResponse::Unhandled;
+
+        if (injector.apply(res)) {
+            counter.count("injected_" + std::to_string(res.status));
+
+            return httplib::Server::HandlerResponse::Handled;
+        }
+
+        return httplib::Server::HandlerResponse::Unhandled;
+    });
+
+    // Trading API: GET /v2/assets
+    server->Get("/v2/assets", [&](const httplib::Request& req, httplib::Response& res) {
+        counter.count("assets");
+
+        std::string requestedExchange = req.has_param("exchange") ? req.get_param_value("exchange") : exchange;
+
+        res.set_content(requestedExchange == exchange ? listingBody : std::string("[]"), "application/json");
+    });
+
+    // Trading API: GET /v2/assets/{symbol}
+    server->Get(R"(/v2/assets/([A-Za-z0-9.\-]+))", [&](const httplib::Request& req, httplib::Response& res) {
+        counter.count("asset");
+
+        const SyntheticAsset* asset = market.find(req.matches[1].str());
+
+        if (asset == nullptr) {
+            res.status = 404;
+            res.set_content(R"({"code":40410000,"message":"asset not found"})", "application/json");
+
+            return;
+        }
+
+        res.set_content(assetToJson(*asset, exchange).dump(), "application/json");
+    });
+
+    // Data API: GET /v2/stocks/trades/latest?symbols=A,B
+    server->Get("/v2/stocks/trades/latest", [&](const httplib::Request& req, httplib::Response& res) {
+        counter.count("trades_latest");
+
+        nlohmann::json trades = nlohmann::json::object();
+
+        for (const std::string& symbol : splitSymbols(req.get_param_value("symbols"))) {
+            const SyntheticAsset* asset = market.find(symbol);
+
+            if (asset == nullptr || market.tradingDays() == 0)
+                continue;
+
+            const SyntheticBar& bar = lastBar(*asset);
+
+            trades[symbol] = {
+                {"t", formatTimestamp(bar.Timestamp + 11 * 3600)},
+                {"x", "V"},
+                {"p", bar.Close},
+                {"s", 100},
+                {"c", nlohmann::json::array({"@"})},
+                {"i", 1},
+                {"z", "A"}
+            };
+        }
+
+        res.set_content(nlohmann::json{{"trades", trades}}.dump(), "application/json");
+    });
+
+    // Data API: GET /v2/stocks/bars?symbols=A,B&timeframe=1D&start=..&end=..&limit=..
+    server->Get("/v2/stocks/bars", [&](const httplib::Request& req, httplib::Response& res) {
+        counter.count("bars");
+
+        std::vector<std::string> symbols = splitSymbols(req.get_param_value("symbols"));
+        std::int64_t start = req.has_param("start") ? parseTimestamp(req.get_param_value("start")) : 0;
+        std::int64_t end = req.has_param("end") ? parseTimestamp(req.get_param_value("end")) : INT64_MAX;
+        std::size_t limit = req.has_param("limit") ? static_cast<std::size_t>(std::strtoull(req.get_param_value("limit").c_str(), nullptr, 10)) : 1000;
+
+        limit = std::clamp<std::size_t>(limit, 1, 1000);
+
+        // The limit applies per symbol, a client reads further bars by asking again with a later start
+        nlohmann::json bars = nlohmann::json::object();
+
+        for (const std::string& symbol : symbols) {
+            const SyntheticAsset* asset = market.find(symbol);
+            std::size_t written = 0;
+
+            if (asset == nullptr)
+                continue;
+
+            for (const SyntheticBar& bar : market.bars(*asset)) {
+                if (bar.Timestamp < start || bar.Timestamp > end)
+                    continue;
+
+                if (written++ == limit)
+                    break;
+
+                bars[symbol].push_back(barToJson(bar));
+            }
+        }
+
+        nlohmann::json body = {{"bars", bars}};
+
+        res.set_content(body.dump(), "application/json");
+    });
+
+    // Request counts per endpoint, useful to check how many round trips a scan needed
+    server->Get("/mock/stats", [&](const httplib::Request&, httplib::Response& res) {
+        res.set_content(counter.toJson().dump(2), "application/json");
+    });
+
+    std::cerr << "Serving " << market.assets().size() << " mock " << exchange << " assets on " << host << ":" << port << std::endl;
+
+    if (!server->listen(host.c_str(), port)) {
+        std::cerr << "Failed to listen on " << host << ":" << port << std::endl;
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "Core/ScanEngine.h"
+#include "Core/ResultExport.h"
+#include "Database/CacheDatabase.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+// Headless scanner: runs the same pipeline as the GUI and writes ranked results as CSV or JSON
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    QCoreApplication::setApplicationName("stockhound-scan");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Scan an exchange and rank stocks within a budget by their StockHound score.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption budgetOption({"b", "budget"}, "Maximum share price to consider.", "amount");
+    QCommandLineOption exchangeOption({"e", "exchange"}, "Exchange to scan.", "exchange", "NYSE");
+    QCommandLineOption databaseOption({"d", "db"}, "Path to the SQLite cache.", "path", CacheDatabase::defaultPath());
+    QCommandLineOption formatOption({"f", "format"}, "Output format, csv or json.", "format", "csv");
+    QCommandLineOption outputOption({"o", "output"}, "Write results to a file instead of stdout.", "path");
+    QCommandLineOption concurrencyOption("concurrency", "Maximum API requests in flight.", "count", "4");
+    QCommandLineOption rateLimitOption("rate-limit", "API requests allowed per minute, 0 for unlimited.", "count", "200");
+    QCommandLineOption threadsOption("threads", "Threads used for scoring, 0 for every core.", "count", "0");
+    QCommandLineOption maxScoreOption("max-score", "Exclude symbols whose total score reaches this value.", "score", "1.1");
+    QCommandLineOption minHistoryOption("min-history", "Exclude symbols with fewer daily bars than this.", "bars", "10");
+    QCommandLineOption apiUrlOption("api-url", "Alpaca trading API host, also used for market data unless --data-url is set.", "host[:port]");
+    QCommandLineOption dataUrlOption("data-url", "Alpaca market data API host.", "host[:port]");
+    QCommandLineOption noValidateOption("no-validate", "Skip reconciling cached prices and suspicious scores after the scan.");
+    QCommandLineOption metricsOption("metrics", "Write per-stage timings and request metrics here, JSON for .json files and Prometheus text otherwise.", "path");
+    QCommandLineOption topOption("top", "Keep only this many of the best candidates, 0 for all. Defaults to STOCKHOUND_TOP_K.", "count");
+    QCommandLineOption sectorCapOption("sector-cap", "Keep at most this many candidates per sector, 0 for no cap. Defaults to STOCKHOUND_SECTOR_CAP.", "count");
+    QCommandLineOption sectorsOption("sectors", "CSV of symbol,sector lines used by --sector-cap. Defaults to STOCKHOUND_SECTORS.", "path");
+    QCommandLineOption weightsOption("weights", "Indicator weights of the total score, e.g. ma=0.4,rsi=0.3,bb=0.3,macd=0.1. Defaults to STOCKHOUND_WEIGHTS.", "weights");
+
+    parser.addOptions({ budgetOption, exchangeOption, databaseOption, formatOption, outputOption, concurrencyOption, rateLimitOption, threadsOption, maxScoreOption, minHistoryOption,
+                        apiUrlOption, dataUrlOption, noValidateOption, metricsOption, weightsOption, topOption, sectorCapOption, sectorsOption });
+    parser.process(application);
+
+    bool isNumber = false;
+    double budget = parser.value(budgetOption).toDouble(&isNumber);
+
+    if (!isNumber || budget <= 0) {
+        std::cerr << "Please enter a valid budget with --budget." << std::endl;
+
+        return 1;
+    }
+
+    QString format = parser.value(formatOption).toLower();
+
+    if (format != "csv" && format != "json") {
+        std::cerr << "Unknown output format: " << format.toStdString() << std::endl;
+
+        return 1;
+    }
+
+    // The Alpaca client reads its endpoints from the environment, so these override it for this process only
+    if (parser.isSet(apiUrlOption)) {
+        qputenv("APCA_API_BASE_URL", parser.value(apiUrlOption).toUtf8());
+        qputenv("APCA_API_DATA_URL", parser.value(apiUrlOption).toUtf8());
+    }
+
+    if (parser.isSet(dataUrlOption))
+        qputenv("APCA_API_DATA_URL", parser.value(dataUrlOption).toUtf8());
+
+    QSqlDatabase db;
+    QString errorMessage;
+
+    QStringList migrations;
+
+    if (!CacheDatabase::open(db, parser.value(databaseOption), QLatin1String(QSqlDatabase::defaultConnection), errorMessage, &migrations)) {
+        std::cerr << errorMessage.toStdString() << std::endl;
+
+        return 2;
+    }
+
+    for (const QString& migration : migrations)
+        std::clog << migration.toStdString() << std::endl;
+
+    ScanOptions options;
+
+    options.budget = budget;
+    options.exchange = parser.value(exchangeOption).toStdString();
+    options.fetch.maxInFlight = std::max(1, parser.value(concurrencyOption).toInt());
+    options.fetch.requestsPerMinute = std::max(0.0, parser.value(rateLimitOption).toDouble());
+    options.scoreThreads = static_cast<unsigned>(std::max(0, parser.value(threadsOption).toInt()));
+    options.exclusion.scoreCeiling = parser.value(maxScoreOption).toDouble();
+    options.exclusion.minHistoryBars = std::max(0, parser.value(minHistoryOption).toInt());
+    options.collectMetrics = parser.isSet(metricsOption);
+    options.metricsPath = parser.value(metricsOption).toStdString();
+    options.validateCache = !parser.isSet(noValidateOption);
+    std::string weightsError;
+
+    if (!ScoreWeights::fromEnvironment(options.weights, weightsError))
+        std::cerr << weightsError << std::endl;
+
+    if (parser.isSet(weightsOption) && !ScoreWeights::parse(parser.value(weightsOption).toStdString(), options.weights, weightsError)) {
+        std::cerr << "Invalid --weights: " << weightsError << std::endl;
+
+        return 1;
+    }
+
+    std::string limitsError;
+
+    if (!CandidateLimits::fromEnvironment(options.candidates, limitsError))
+        std::cerr << limitsError << std::endl;
+
+    if (parser.isSet(topOption))
+        options.candidates.topK = static_cast<std::size_t>(std::max(0, parser.value(topOption).toInt()));
+
+    if (parser.isSet(sectorCapOption))
+        options.candidates.perSector = static_cast<std::size_t>(std::max(0, parser.value(sectorCapOption).toInt()));
+
+    std::string sectorsError;
+
+    if (parser.isSet(sectorsOption)) {
+        options.candidates.sectors.clear();
+
+        if (!CandidateLimits::loadSectors(parser.value(sectorsOption).toStdString(), options.candidates.sectors, sectorsError)) {
+            std::cerr << sectorsError << std::endl;
+
+            return 1;
+        }
+    }
+
+    ScanEngine engine(db);
+    ScanCallbacks callbacks;
+    QElapsedTimer timer;
+
+    callbacks.log = [](const std::string& message) {
+        std::clog << message << std::endl;
+    };
+    engine.setCallbacks(std::move(callbacks));
+
+    timer.start();
+
+    if (!engine.run(options)) {
+        std::cerr << "Scan failed: " << engine.lastError().toStdString() << std::endl;
+
+        return 2;
+    }
+
+    std::vector<StockInformation> results = engine.results();
+
+    ResultExport::rank(results);
+
+    std::ofstream file;
+
+    if (parser.isSet(outputOption)) {
+        file.open(parser.value(outputOption).toStdString());
+
+        if (!file) {
+            std::cerr << "Failed to open output file: " << parser.value(outputOption).toStdString() << std::endl;
+
+            return 2;
+        }
+    }
+
+    std::ostream& out = file.is_open() ? static_cast<std::ostream&>(file) : std::cout;
+
+    if (format == "json")
+        ResultExport::writeJson(out, results);
+    else
+        ResultExport::writeCsv(out, results);
+
+    std::cerr << "Scanned " << options.exchange << " in " << timer.elapsed() << " ms, " << results.size() << " candidates." << std::endl;
+
+    if (engine.metrics())
+        std::cerr << engine.metrics()->summary().toStdString() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "SyntheticMarket.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+    constexpr double pi = 3.14159265358979323846;
+
+    // Volatility clustering, variance follows a GARCH(1,1) around each asset's long-run level
+    constexpr double garchShock = 0.07;
+    constexpr double garchPersistence = 0.90;
+
+    // Returns fed back into the variance are capped at this many long-run deviations, so one jump cannot run away
+    constexpr double garchCap = 4.0;
+
+    // std::normal_distribution differs between standard libraries, mt19937_64 does not. The transform below only
+    // varies with the math library's rounding
+    class Random {
+    public:
+        explicit Random(std::uint64_t seed) : engine(seed) {}
+
+        double uniform() {
+            return (static_cast<double>(engine() >> 11) + 0.5) * 0x1.0p-53;
+        }
+
+        double uniform(double low, double high) {
+            return low + (high - low) * uniform();
+        }
+
+        // Log-uniform, for quantities spread over orders of magnitude like prices and volumes
+        double logUniform(double low, double high) {
+            return std::exp(uniform(std::log(low), std::log(high)));
+        }
+
+        double normal() {
+            if (hasSpare) {
+                hasSpare = false;
+
+                return spare;
+            }
+
+            double radius = std::sqrt(-2.0 * std::log(uniform()));
+            double angle = 2.0 * pi * uniform();
+
+            spare = radius * std::sin(angle);
+            hasSpare = true;
+
+            return radius * std::cos(angle);
+        }
+
+    private:
+        std::mt19937_64 engine;
+        double spare = 0.0;
+        bool hasSpare = false;
+    };
+
+    // SplitMix64 finalizer, turns the seed and a stream number into well separated engine seeds
+    std::uint64_t streamSeed(unsigned seed, std::uint64_t stream) {
+        std::uint64_t z = (static_cast<std::uint64_t>(seed) << 32) + stream * 0x9E3779B97F4A7C15ULL;
+
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+        return z ^ (z >> 31);
+    }
+
+    // Mostly normal, now and then a jump several times larger, which gives the fat tails of real returns
+    double shock(Random& random) {
+        double z = random.normal();
+
+        return random.uniform() < 0.004 ? z * 3.0 : z;
+    }
+
+    double roundPrice(double price) {
+        double scale = price >= 1.0 ? 100.0 : 10000.0;
+
+        return std::max(0.0001, std::round(price * scale) / scale);
+    }
+
+    // Factor series, market first then one per sector, clustered like asset returns
+    std::vector<double> factorReturns(unsigned seed, std::uint64_t stream, std::size_t days, double dailyVolatility) {
+        Random random(streamSeed(seed, stream));
+        std::vector<double> returns(days);
+        double longRunVariance = dailyVolatility * dailyVolatility;
+        double variance = longRunVariance;
+        double previous = 0.0;
+
+        for (double& value : returns) {
+            variance = longRunVariance * (1.0 - garchShock - garchPersistence) + garchShock * previous * previous + garchPersistence * variance;
+            value = std::sqrt(variance) * shock(random);
+            previous = std::clamp(value, -garchCap * dailyVolatility, garchCap * dailyVolatility);
+        }
+
+        return returns;
+    }
+
+    const char* const nameSuffixes[] = { "Holdings Inc.", "Corp.", "Group Ltd.", "Industries", "Technologies Inc.", "Partners LP", "Bancorp", "Energy Co." };
+}
+
+SyntheticMarket::SyntheticMarket(const SyntheticMarketOptions& options) : seed(options.seed) {
+    std::int64_t endDay = options.endDay;
+
+    if (endDay == 0)
+        endDay = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 86400;
+
+    for (std::int64_t day = endDay - options.days; day < endDay; ++day) {
+        // 1970-01-01 was a Thursday, skip Saturdays and Sundays
+        std::int64_t weekday = ((day + 4) % 7 + 7) % 7;
+
+        if (weekday != 0 && weekday != 6)
+            timestamps.push_back(day * 86400 + 5 * 3600);
+    }
+
+    // Streams 0 to sectorCount are the factors, assets use the ones after
+    marketReturns = factorReturns(seed, 0, timestamps.size(), 0.009);
+    sectorReturns.reserve(timestamps.size() * sectorCount);
+
+    for (int sector = 0; sector < sectorCount; ++sector) {
+        std::vector<double> returns = factorReturns(seed, 1 + static_cast<std::uint64_t>(sector), timestamps.size(), 0.006);
+
+        sectorReturns.insert(sectorReturns.end(), returns.begin(), returns.end());
+    }
+
+    universe.reserve(options.symbols);
+    indexBySymbol.reserve(options.symbols);
+
+    for (std::size_t i = 0; i < options.symbols; ++i) {
+        SyntheticAsset asset;
+
+        asset.Symbol = ticker(i);
+        asset.Id = "mock-" + asset.Symbol;
+        asset.Name = asset.Symbol + " " + nameSuffixes[streamSeed(seed, i) % std::size(nameSuffixes)];
+        asset.Sector = static_cast<int>(streamSeed(seed + 1, i) % sectorCount);
+        asset.Tradable = (i % 50) != 49; // A few untradable assets like the real listing
+
+        indexBySymbol.emplace(asset.Symbol, i);
+        universe.push_back(std::move(asset));
+    }
+}
+
+const std::vector<SyntheticAsset>& SyntheticMarket::assets() const {
+    return universe;
+}
+
+const SyntheticAsset* SyntheticMarket::find(const std::string& symbol) const {
+    auto it = indexBySymbol.find(symbol);
+
+    return it != indexBySymbol.end() ? &universe[it->second] : nullptr;
+}
+
+std::size_t SyntheticMarket::tradingDays() const {
+    return timestamps.size();
+}
+
+std::vector<SyntheticBar> SyntheticMarket::bars(const SyntheticAsset& asset) const {
+    const std::size_t index = static_cast<std::size_t>(&asset - universe.data());
+    const std::size_t days = timestamps.size();
+    const double* sector = sectorReturns.data() + static_cast<std::size_t>(asset.Sector) * days;
+    Random random(streamSeed(seed, 1 + sectorCount + index));
+
+    // Per-asset character: what it costs, how much it trades, how much it moves and how much of that is the market
+    double close = random.logUniform(1.0, 400.0);
+    const double averageVolume = random.logUniform(2.0e4, 3.0e7);
+    const double dailyVolatility = random.logUniform(0.12, 0.90) / std::sqrt(252.0);
+    const double beta = random.uniform(0.5, 1.6);
+    const double sectorLoading = random.uniform(0.3, 1.0);
+    const double drift = random.normal() * 0.0004;
+    const double averageTradeSize = random.uniform(60.0, 250.0);
+    const double longRunVariance = dailyVolatility * dailyVolatility;
+    double variance = longRunVariance;
+    double previous = 0.0;
+    std::vector<SyntheticBar> series;
+
+    series.reserve(days);
+
+    for (std::size_t day = 0; day < days; ++day) {
+        variance = longRunVariance * (1.0 - garchShock - garchPersistence) + garchShock * previous * previous + garchPersistence * variance;
+
+        const double ownReturn = std::sqrt(variance) * shock(random);
+        const double totalReturn = drift + beta * marketReturns[day] + sectorLoading * sector[day] + ownReturn;
+        const double scale = std::sqrt(variance + longRunVariance) / std::sqrt(2.0);
+
+        // About a third of the day's move happens overnight and shows up as a gap at the open
+        double open = roundPrice(close * std::exp(0.35 * totalReturn + 0.25 * scale * random.normal()));
+        double nextClose = roundPrice(close * std::exp(totalReturn));
+        double high = roundPrice(std::max(open, nextClose) * std::exp(0.5 * scale * std::abs(random.normal())));
+        double low = roundPrice(std::min(open, nextClose) * std::exp(-0.5 * scale * std::abs(random.normal())));
+
+        // Volume is lognormal around the asset's average and climbs with the size of the move
+        double activity = std::exp(0.35 * random.normal()) * (0.6 + 0.8 * std::abs(totalReturn) / std::max(scale, 1e-9));
+        std::int64_t volume = std::max<std::int64_t>(100, std::llround(averageVolume * activity / 100.0) * 100);
+        double vwap = std::clamp((high + low + 2.0 * nextClose) / 4.0, low, high);
+
+        series.push_back(SyntheticBar{ timestamps[day], open, high, low, nextClose, volume,
+                                       std::max<std::int64_t>(1, std::llround(static_cast<double>(volume) / averageTradeSize)), vwap });
+
+        previous = std::clamp(ownReturn, -garchCap * dailyVolatility, garchCap * dailyVolatility);
+        close = nextClose;
+    }
+
+    return series;
+}
+
+std::string SyntheticMarket::ticker(std::size_t index) {
+    std::string symbol;
+
+    // Bijective base 26, like spreadsheet columns
+    for (std::size_t n = index + 1; n > 0; n = (n - 1) / 26)
+        symbol.insert(symbol.begin(), static_cast<char>('A' + (n - 1) % 26));
+
+    return symbol;
+}
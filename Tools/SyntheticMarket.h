@@ -0,0 +1,70 @@
+#ifndef SYNTHETIC_MARKET_H
+#define SYNTHETIC_MARKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SyntheticMarketOptions {
+    std::size_t symbols = 500;
+    int days = 60;                // Calendar days of history, weekends are skipped
+    unsigned seed = 1;
+    std::int64_t endDay = 0;      // Days since 1970-01-01 the history ends before, 0 for today
+};
+
+struct SyntheticAsset {
+    std::string Id;
+    std::string Symbol;
+    std::string Name;
+    int Sector;                   // 0 to sectorCount - 1, assets of a sector move together
+    bool Tradable;
+};
+
+struct SyntheticBar {
+    std::int64_t Timestamp;
+    double Open;
+    double High;
+    double Low;
+    double Close;
+    std::int64_t Volume;
+    std::int64_t TradeCount;
+    double Vwap;
+};
+
+// Deterministic market of daily OHLCV bars. Every asset follows a market and a sector factor plus its own
+// volatility-clustered, fat-tailed returns, with overnight gaps and volume that rises on large moves.
+// Bars are generated on request from a per-asset random stream rather than stored, so a universe of a hundred
+// thousand symbols costs a few megabytes, and an asset's series does not depend on how many assets there are.
+// The same seed and end day give the same bars on the same platform and build. std::exp, log, sin and cos are not
+// correctly rounded, so other math libraries or compiler flags can move the last digits and, through rounding, prices.
+class SyntheticMarket {
+public:
+    static constexpr int sectorCount = 11;
+
+    explicit SyntheticMarket(const SyntheticMarketOptions& options);
+
+    const std::vector<SyntheticAsset>& assets() const;
+
+    // Returns nullptr for unknown symbols
+    const SyntheticAsset* find(const std::string& symbol) const;
+
+    // Every bar of the asset in time order
+    std::vector<SyntheticBar> bars(const SyntheticAsset& asset) const;
+
+    std::size_t tradingDays() const;
+
+    // A, B, ..., Z, AA, AB, ... so the first 475254 tickers are one to four letters
+    static std::string ticker(std::size_t index);
+
+private:
+    unsigned seed;
+    std::vector<std::int64_t> timestamps;          // One per trading day
+    std::vector<double> marketReturns;             // Daily log returns shared by every asset
+    std::vector<double> sectorReturns;             // sectorCount series of tradingDays() log returns, back to back
+    std::vector<SyntheticAsset> universe;
+    std::unordered_map<std::string, std::size_t> indexBySymbol;
+};
+
+#endif // SYNTHETIC_MARKET_H
@@ -0,0 +1,303 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Local stand-in for the Alpaca trade stream, so live mode can run offline.
+// Point APCA_API_STREAM_URL at ws://127.0.0.1:<port> and any key is accepted.
+
+namespace {
+    struct ReplayClient {
+        bool Authenticated = false;
+        std::set<std::string> Trades;   // "*" subscribes to every symbol
+    };
+
+    class ReplayServer {
+    public:
+        ReplayServer(double tradesPerSecond, unsigned seed) : random(seed), server("stockhound-trade-replay", QWebSocketServer::NonSecureMode) {
+            QObject::connect(&server, &QWebSocketServer::newConnection, [this]() {
+                while (server.hasPendingConnections())
+                    accept(server.nextPendingConnection());
+            });
+
+            walkTimer.setInterval(std::max(1, static_cast<int>(1000.0 / std::max(tradesPerSecond, 0.001))));
+            QObject::connect(&walkTimer, &QTimer::timeout, [this]() { walk(); });
+        }
+
+        bool listen(quint16 port) {
+            if (!server.listen(QHostAddress::LocalHost, port)) {
+                std::cerr << "Listening failed: " << server.errorString().toStdString() << std::endl;
+
+                return false;
+            }
+
+            std::clog << "Streaming trades on ws://127.0.0.1:" << server.serverPort() << std::endl;
+
+            return true;
+        }
+
+        // Seeds the random walk with the last trade price of every cached symbol
+        bool seedPrices(const QString& dbPath) {
+            bool loaded = false;
+
+            {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "trade-replay");
+
+                db.setDatabaseName(dbPath);
+
+                if (!db.open()) {
+                    std::cerr << "Opening " << dbPath.toStdString() << " failed: " << db.lastError().text().toStdString() << std::endl;
+                } else {
+                    QSqlQuery query("SELECT symbol, price FROM trades WHERE price > 0", db);
+
+                    while (query.next())
+                        prices[query.value(0).toString().toStdString()] = query.value(1).toDouble();
+
+                    loaded = query.lastError().type() == QSqlError::NoError;
+
+                    if (!loaded)
+                        std::cerr << "Query execution failed: " << query.lastError().text().toStdString() << std::endl;
+                    else
+                        std::clog << "Seeded " << prices.size() << " prices from " << dbPath.toStdString() << std::endl;
+                }
+            }
+
+            QSqlDatabase::removeDatabase("trade-replay");
+
+            return loaded;
+        }
+
+        // Loads one Alpaca trade message per line, they are sent in file order at their recorded spacing
+        bool loadRecording(const QString& path) {
+            QFile file(path);
+
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                std::cerr << "Opening " << path.toStdString() << " failed: " << file.errorString().toStdString() << std::endl;
+
+                return false;
+            }
+
+            while (!file.atEnd()) {
+                std::string line = file.readLine().trimmed().toStdString();
+
+                if (line.empty())
+                    continue;
+
+                nlohmann::json trade = nlohmann::json::parse(line, nullptr, false);
+
+                if (trade.is_discarded() || !trade.is_object() || !trade.contains("S") || !trade.contains("p")) {
+                    std::cerr << "Skipping malformed line: " << line << std::endl;
+
+                    continue;
+                }
+
+                trade["T"] = "t";
+                recording.push_back(std::move(trade));
+            }
+
+            std::clog << "Loaded " << recording.size() << " recorded trades from " << path.toStdString() << std::endl;
+
+            return !recording.empty();
+        }
+
+        void start(double speed) {
+            replaySpeed = std::max(speed, 0.001);
+
+            if (recording.empty())
+                walkTimer.start();
+            else
+                replayNext();
+        }
+
+    private:
+        std::mt19937 random;
+        QWebSocketServer server;
+        QTimer walkTimer;
+        std::map<QWebSocket*, ReplayClient> clients;
+        std::unordered_map<std::string, double> prices;
+        std::vector<nlohmann::json> recording;
+        std::size_t recordingPosition = 0;
+        double replaySpeed = 1.0;
+
+        void accept(QWebSocket* socket) {
+            clients.emplace(socket, ReplayClient());
+
+            QObject::connect(socket, &QWebSocket::textMessageReceived, [this, socket](const QString& message) {
+                handle(socket, message.toStdString());
+            });
+            QObject::connect(socket, &QWebSocket::disconnected, [this, socket]() {
+                clients.erase(socket);
+                socket->deleteLater();
+            });
+
+            send(socket, nlohmann::json::array({ { { "T", "success" }, { "msg", "connected" } } }));
+        }
+
+        void handle(QWebSocket* socket, const std::string& message) {
+            nlohmann::json request = nlohmann::json::parse(message, nullptr, false);
+            ReplayClient& client = clients[socket];
+
+            if (request.is_discarded() || !request.is_object()) {
+                send(socket, nlohmann::json::array({ { { "T", "error" }, { "code", 400 }, { "msg", "invalid syntax" } } }));
+
+                return;
+            }
+
+            std::string action = request.value("action", "");
+
+            if (action == "auth") {
+                client.Authenticated = true;
+                send(socket, nlohmann::json::array({ { { "T", "success" }, { "msg", "authenticated" } } }));
+
+                return;
+            }
+
+            if (!client.Authenticated) {
+                send(socket, nlohmann::json::array({ { { "T", "error" }, { "code", 401 }, { "msg", "not authenticated" } } }));
+
+                return;
+            }
+
+            if (action != "subscribe" && action != "unsubscribe") {
+                send(socket, nlohmann::json::array({ { { "T", "error" }, { "code", 400 }, { "msg", "invalid syntax" } } }));
+
+                return;
+            }
+
+            for (const nlohmann::json& symbol : request.value("trades", nlohmann::json::array())) {
+                if (!symbol.is_string())
+                    continue;
+
+                if (action == "subscribe")
+                    client.Trades.insert(symbol.get<std::string>());
+                else
+                    client.Trades.erase(symbol.get<std::string>());
+            }
+
+            send(socket, nlohmann::json::array({ { { "T", "subscription" }, { "trades", client.Trades }, { "quotes", nlohmann::json::array() }, { "bars", nlohmann::json::array() } } }));
+        }
+
+        void send(QWebSocket* socket, const nlohmann::json& message) {
+            socket->sendTextMessage(QString::fromStdString(message.dump()));
+        }
+
+        void broadcast(const nlohmann::json& trade) {
+            const std::string symbol = trade.value("S", "");
+            const std::string message = nlohmann::json::array({ trade }).dump();
+
+            for (const auto& [socket, client] : clients) {
+                if (client.Authenticated && (client.Trades.count(symbol) || client.Trades.count("*")))
+                    socket->sendTextMessage(QString::fromStdString(message));
+            }
+        }
+
+        // Sends one trade for a random subscribed symbol, prices follow a geometric random walk
+        void walk() {
+            std::vector<std::string> symbols;
+
+            for (const auto& [socket, client] : clients) {
+                for (const std::string& symbol : client.Trades) {
+                    if (symbol == "*") {
+                        for (const auto& [cached, price] : prices)
+                            symbols.push_back(cached);
+                    } else {
+                        symbols.push_back(symbol);
+                    }
+                }
+            }
+
+            if (symbols.empty())
+                return;
+
+            const std::string& symbol = symbols[std::uniform_int_distribution<std::size_t>(0, symbols.size() - 1)(random)];
+            auto price = prices.try_emplace(symbol, std::uniform_real_distribution<double>(5.0, 100.0)(random)).first;
+
+            price->second = std::max(0.01, price->second * (1.0 + std::normal_distribution<double>(0.0, 0.002)(random)));
+
+            broadcast({
+                { "T", "t" },
+                { "S", symbol },
+                { "p", std::round(price->second * 100.0) / 100.0 },
+                { "s", std::uniform_int_distribution<int>(1, 500)(random) },
+                { "t", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs).toStdString() }
+            });
+        }
+
+        // Sends the next recorded trade and schedules the one after it, the recording loops at the end
+        void replayNext() {
+            nlohmann::json trade = recording[recordingPosition];
+            const std::string recordedTime = trade.value("t", "");
+            qint64 delayMs = 0;
+
+            trade["t"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs).toStdString();
+            broadcast(trade);
+
+            recordingPosition = (recordingPosition + 1) % recording.size();
+
+            if (recordingPosition != 0) {
+                QDateTime current = QDateTime::fromString(QString::fromStdString(recordedTime), Qt::ISODateWithMs);
+                QDateTime next = QDateTime::fromString(QString::fromStdString(recording[recordingPosition].value("t", "")), Qt::ISODateWithMs);
+
+                // Gaps are capped so a recording spanning a market close does not stall the replay
+                if (current.isValid() && next.isValid())
+                    delayMs = std::clamp<qint64>(static_cast<qint64>(current.msecsTo(next) / replaySpeed), 0, 5000);
+            }
+
+            QTimer::singleShot(static_cast<int>(delayMs), [this]() { replayNext(); });
+        }
+    };
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication application(argc, argv);
+
+    QCoreApplication::setApplicationName("stockhound-trade-replay");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Serve the Alpaca trade stream protocol locally, from a recording or a random walk.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption portOption({"p", "port"}, "Port to listen on.", "port", "8090");
+    QCommandLineOption databaseOption({"d", "db"}, "SQLite cache whose last trade prices seed the random walk.", "path");
+    QCommandLineOption fileOption({"f", "file"}, "Replay Alpaca trade messages from a JSON lines file instead.", "path");
+    QCommandLineOption speedOption("speed", "Replay speed multiplier for --file.", "factor", "1");
+    QCommandLineOption rateOption("rate", "Random walk trades per second.", "count", "50");
+    QCommandLineOption seedOption("seed", "Random walk seed.", "seed", "1");
+
+    parser.addOptions({ portOption, databaseOption, fileOption, speedOption, rateOption, seedOption });
+    parser.process(application);
+
+    ReplayServer server(parser.value(rateOption).toDouble(), parser.value(seedOption).toUInt());
+
+    if (parser.isSet(databaseOption) && !server.seedPrices(parser.value(databaseOption)))
+        return 1;
+
+    if (parser.isSet(fileOption) && !server.loadRecording(parser.value(fileOption)))
+        return 1;
+
+    if (!server.listen(static_cast<quint16>(parser.value(portOption).toUInt())))
+        return 1;
+
+    server.start(parser.value(speedOption).toDouble());
+
+    return application.exec();
+}